@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <chrono>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "async.h"
+#include "loop.h"
+
+
+namespace {
+
+using namespace siren;
+
+
+template <class T>
+double
+MeasureThroughput(std::size_t numberOfCalls, T &&procedure)
+{
+    Loop loop;
+    Async async(&loop, 1);
+    double throughput = 0.0;
+
+    loop.createFiber([&] () -> void {
+        auto startTime = std::chrono::steady_clock::now();
+
+        for (std::size_t i = 0; i < numberOfCalls; ++i) {
+            procedure(&async);
+        }
+
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+        throughput = numberOfCalls / duration.count();
+    });
+
+    loop.run();
+    return throughput;
+}
+
+} // namespace
+
+
+int
+main()
+{
+    constexpr std::size_t numberOfCalls = 200000;
+    int fd = open("/dev/zero", O_RDONLY);
+
+    if (fd < 0) {
+        std::perror("open() failed");
+        return 1;
+    }
+
+    std::printf("Async::callFunction(read):    %12.0f calls/s\n"
+                , MeasureThroughput(numberOfCalls, [&] (Async *async) -> void {
+        char buffer[64];
+        async->callFunction(::read, fd, buffer, sizeof(buffer));
+    }));
+
+    std::printf("Async::callFunction(getpid):  %12.0f calls/s\n"
+                , MeasureThroughput(numberOfCalls, [&] (Async *async) -> void {
+        async->callFunction(getpid);
+    }));
+
+    std::printf("Async::executeTask:           %12.0f calls/s\n"
+                , MeasureThroughput(numberOfCalls, [&] (Async *async) -> void {
+        async->executeTask([] () -> void {
+        });
+    }));
+
+    close(fd);
+    return 0;
+}
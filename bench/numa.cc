@@ -0,0 +1,161 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <memory>
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "memory_pool.h"
+#include "thread_pool.h"
+
+
+namespace {
+
+using namespace siren;
+
+
+struct MyThreadPoolTask : ThreadPoolTask
+{
+};
+
+
+bool
+GetLocalCPUs(cpu_set_t *cpuSet)
+{
+    unsigned int numaNode;
+
+    if (syscall(SYS_getcpu, nullptr, &numaNode, nullptr) < 0) {
+        return false;
+    }
+
+    char path[64];
+    std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", numaNode);
+    std::FILE *file = std::fopen(path, "r");
+
+    if (file == nullptr) {
+        return false;
+    }
+
+    CPU_ZERO(cpuSet);
+    int cpu1, cpu2;
+    int n;
+
+    while ((n = std::fscanf(file, "%d-%d", &cpu1, &cpu2)) >= 1) {
+        if (n == 1) {
+            cpu2 = cpu1;
+        }
+
+        for (int cpu = cpu1; cpu <= cpu2; ++cpu) {
+            CPU_SET(cpu, cpuSet);
+        }
+
+        if (std::fgetc(file) != ',') {
+            break;
+        }
+    }
+
+    std::fclose(file);
+    return CPU_COUNT(cpuSet) >= 1;
+}
+
+
+double
+MeasureBandwidth(std::size_t numberOfThreads, bool isLocal)
+{
+    constexpr std::size_t blockSize = 1 << 20;
+    constexpr std::size_t numberOfBlocks = 64;
+    constexpr std::size_t numberOfPasses = 16;
+
+    MemoryPool memoryPool(alignof(std::uint64_t), blockSize);
+    ThreadPool threadPool(numberOfThreads);
+
+    if (isLocal) {
+        cpu_set_t cpuSet;
+
+        if (!GetLocalCPUs(&cpuSet) || sched_setaffinity(0, sizeof(cpuSet), &cpuSet) < 0) {
+            std::perror("sched_setaffinity() failed");
+            return 0.0;
+        }
+
+        memoryPool.setNUMALocal(true);
+        threadPool.setCPUAffinity(cpuSet);
+    }
+
+    void *blocks[numberOfBlocks];
+
+    for (std::size_t i = 0; i < numberOfBlocks; ++i) {
+        blocks[i] = memoryPool.allocateBlock();
+        std::memset(blocks[i], i, blockSize);
+    }
+
+    std::unique_ptr<MyThreadPoolTask []> tasks(new MyThreadPoolTask[numberOfBlocks]);
+    std::uint64_t sums[numberOfBlocks];
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (std::size_t i = 0; i < numberOfBlocks; ++i) {
+        threadPool.addTask(&tasks[i], [&blocks, &sums, i] () -> void {
+            auto words = static_cast<const volatile std::uint64_t *>(blocks[i]);
+            std::uint64_t sum = 0;
+
+            for (std::size_t j = 0; j < numberOfPasses; ++j) {
+                for (std::size_t k = 0; k < blockSize / sizeof(*words); ++k) {
+                    sum += words[k];
+                }
+            }
+
+            sums[i] = sum;
+        });
+    }
+
+    std::size_t numberOfCompletedTasks = 0;
+
+    while (numberOfCompletedTasks < numberOfBlocks) {
+        std::uint64_t dummy;
+
+        if (read(threadPool.getEventFD(), &dummy, sizeof(dummy)) < 0) {
+            std::perror("read() failed");
+            return 0.0;
+        }
+
+        threadPool.removeCompletedTasks([&] (ThreadPoolTask *task) -> void {
+            task->check();
+            ++numberOfCompletedTasks;
+        });
+    }
+
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+
+    for (std::size_t i = 0; i < numberOfBlocks; ++i) {
+        memoryPool.freeBlock(blocks[i]);
+    }
+
+    return numberOfBlocks * numberOfPasses * double(blockSize) / duration.count() / (1 << 30);
+}
+
+} // namespace
+
+
+int
+main()
+{
+    cpu_set_t cpuSet;
+
+    if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) < 0) {
+        std::perror("sched_getaffinity() failed");
+        return 1;
+    }
+
+    for (std::size_t numberOfThreads = 1; numberOfThreads <= 16; numberOfThreads *= 2) {
+        double bandwidth1 = MeasureBandwidth(numberOfThreads, false);
+        double bandwidth2 = MeasureBandwidth(numberOfThreads, true);
+        sched_setaffinity(0, sizeof(cpuSet), &cpuSet);
+        std::printf("%2zu threads: %8.2f GiB/s unpinned, %8.2f GiB/s node-local\n"
+                    , numberOfThreads, bandwidth1, bandwidth2);
+    }
+
+    return 0;
+}
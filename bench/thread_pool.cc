@@ -0,0 +1,67 @@
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <memory>
+
+#include <unistd.h>
+
+#include "thread_pool.h"
+
+
+namespace {
+
+using namespace siren;
+
+
+struct MyThreadPoolTask : ThreadPoolTask
+{
+};
+
+
+double
+MeasureThroughput(std::size_t numberOfThreads, std::size_t numberOfTasks)
+{
+    ThreadPool threadPool(numberOfThreads);
+    std::unique_ptr<MyThreadPoolTask []> tasks(new MyThreadPoolTask[numberOfTasks]);
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (std::size_t i = 0; i < numberOfTasks; ++i) {
+        threadPool.addTask(&tasks[i], [] () -> void {
+        });
+    }
+
+    std::size_t numberOfCompletedTasks = 0;
+
+    while (numberOfCompletedTasks < numberOfTasks) {
+        std::uint64_t dummy;
+
+        if (read(threadPool.getEventFD(), &dummy, sizeof(dummy)) < 0) {
+            std::perror("read() failed");
+            return 0.0;
+        }
+
+        threadPool.removeCompletedTasks([&] (ThreadPoolTask *task) -> void {
+            task->check();
+            ++numberOfCompletedTasks;
+        });
+    }
+
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+    return numberOfTasks / duration.count();
+}
+
+} // namespace
+
+
+int
+main()
+{
+    constexpr std::size_t numberOfTasks = 1000000;
+
+    for (std::size_t numberOfThreads = 1; numberOfThreads <= 64; numberOfThreads *= 2) {
+        std::printf("%2zu threads: %12.0f tasks/s\n", numberOfThreads
+                    , MeasureThroughput(numberOfThreads, numberOfTasks));
+    }
+
+    return 0;
+}
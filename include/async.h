@@ -2,8 +2,15 @@
 
 
 #include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
 #include <memory>
 #include <type_traits>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/uio.h>
 
 #include "thread_pool.h"
 
@@ -19,6 +26,9 @@ class Async final
 {
 public:
     inline bool isValid() const noexcept;
+    inline std::uint64_t getNumberOfNoWaitHits() const noexcept;
+    inline std::uint64_t getNumberOfNoWaitMisses() const noexcept;
+    inline const ThreadPool *getThreadPool() const noexcept;
 
     template <class T, class ...U>
     std::enable_if_t<std::is_void<std::result_of_t<T(U ...)>>::value
@@ -29,28 +39,69 @@ public:
                      && !std::is_reference<std::result_of_t<T(U ...)>>::value
                      , std::result_of_t<T(U ...)>> callFunction(T &&, U ...);
 
-    explicit Async(Loop *, std::size_t = 0);
+    explicit Async(Loop *, std::size_t = 0, std::size_t = 0);
     Async(Async &&) noexcept;
     ~Async();
     Async &operator=(Async &&) noexcept;
 
-    void executeTask(const std::function<void ()> &);
-    void executeTask(std::function<void ()> &&);
+    void executeTask(const std::function<void ()> &, ThreadPoolLane = ThreadPoolLane::Interactive);
+    void executeTask(std::function<void ()> &&, ThreadPoolLane = ThreadPoolLane::Interactive);
+
+    std::vector<std::exception_ptr> executeTasks(const std::vector<std::function<void ()>> &
+                                                 , ThreadPoolLane = ThreadPoolLane::Interactive);
+
+    std::size_t executeAnyTask(const std::vector<std::function<void ()>> &
+                               , ThreadPoolLane = ThreadPoolLane::Interactive);
+
+    template <class T>
+    void parallelFor(std::size_t, std::size_t, std::size_t, T &&
+                     , ThreadPoolLane = ThreadPoolLane::Interactive);
+
+    template <class T, class U, class V>
+    T parallelReduce(std::size_t, std::size_t, std::size_t, T, U &&, V &&
+                     , ThreadPoolLane = ThreadPoolLane::Interactive);
+
+    ssize_t read(int, void *, size_t);
+    ssize_t write(int, const void *, size_t);
+    ssize_t readv(int, const iovec *, int);
+    ssize_t writev(int, const iovec *, int);
+    ssize_t pread(int, void *, size_t, off_t);
+    ssize_t pwrite(int, const void *, size_t, off_t);
+    ssize_t preadv(int, const iovec *, int, off_t);
+    ssize_t pwritev(int, const iovec *, int, off_t);
+    int fsync(int);
+    int fdatasync(int);
+    int fallocate(int, int, off_t, off_t);
 
 private:
     typedef detail::AsyncTask Task;
 
     std::unique_ptr<ThreadPool> threadPool_;
+    std::unique_ptr<Event> queueEvent_;
     Loop *loop_;
     void *fiberHandle_;
     std::size_t taskCount_;
+    std::uint64_t numberOfNoWaitHits_;
+    std::uint64_t numberOfNoWaitMisses_;
 
-    static void EventTrigger(ThreadPool *, Loop *) noexcept;
+    static void EventTrigger(ThreadPool *, Event *, Loop *) noexcept;
 
     void initialize();
     void finalize() noexcept;
     void move(Async *) noexcept;
-    void waitForTask(Task *);
+    void runTasks(ThreadPoolTask *const *, std::size_t, void (*)(ThreadPoolTask *), ThreadPoolLane
+                  , std::size_t);
+    bool cancelTasks(ThreadPoolTask *const *, std::size_t);
+    void checkTasks(ThreadPoolTask *const *, std::size_t);
+
+    template <class T>
+    void executeProcedure(T *, ThreadPoolLane = ThreadPoolLane::Interactive);
+
+    template <class T>
+    void executeChunks(std::size_t, std::size_t, std::size_t, T *, ThreadPoolLane);
+
+    template <class T, class U>
+    ssize_t transferFile(T &&, U &&);
 };
 
 } // namespace siren
@@ -62,15 +113,30 @@ private:
 
 
 #include <cerrno>
+#include <algorithm>
 #include <new>
 #include <tuple>
 #include <utility>
 
+#include "assert.h"
 #include "utility.h"
 
 
 namespace siren {
 
+namespace detail {
+
+struct AsyncTask
+  : ThreadPoolTask
+{
+    Event *event;
+    std::size_t *numberOfTasksToWaitFor;
+    bool isCompleted;
+};
+
+} // namespace detail
+
+
 bool
 Async::isValid() const noexcept
 {
@@ -78,6 +144,27 @@ Async::isValid() const noexcept
 }
 
 
+std::uint64_t
+Async::getNumberOfNoWaitHits() const noexcept
+{
+    return numberOfNoWaitHits_;
+}
+
+
+std::uint64_t
+Async::getNumberOfNoWaitMisses() const noexcept
+{
+    return numberOfNoWaitMisses_;
+}
+
+
+const ThreadPool *
+Async::getThreadPool() const noexcept
+{
+    return threadPool_.get();
+}
+
+
 template <class T, class ...U>
 std::enable_if_t<std::is_void<std::result_of_t<T(U ...)>>::value, void>
 Async::callFunction(T &&procedure, U ...argument)
@@ -94,14 +181,16 @@ Async::callFunction(T &&procedure, U ...argument)
         0,
     };
 
-    executeTask([&context] () -> void {
+    auto wrapper = [&context] () -> void {
         struct ErrorNumberCapturer {
             int *errorNumber;
             ~ErrorNumberCapturer() { *errorNumber = errno; }
         } errorNumberCapturer = {&context.errorNumber};
 
         ApplyFunction(std::forward<T>(context.procedure), context.arguments);
-    });
+    };
+
+    executeProcedure(&wrapper);
 
     errno = context.errorNumber;
 }
@@ -128,7 +217,7 @@ Async::callFunction(T &&function, U ...argument)
         0,
     };
 
-    executeTask([&context] () -> void {
+    auto wrapper = [&context] () -> void {
         struct ErrorNumberCapturer {
             int *errorNumber;
             ~ErrorNumberCapturer() { *errorNumber = errno; }
@@ -136,10 +225,127 @@ Async::callFunction(T &&function, U ...argument)
 
         new (context.result) W(ApplyFunction(std::forward<T>(context.function)
                                              , context.arguments));
-    });
+    };
+
+    executeProcedure(&wrapper);
 
     errno = context.errorNumber;
     return *reinterpret_cast<W *>(context.result);
 }
 
+
+template <class T>
+void
+Async::parallelFor(std::size_t begin, std::size_t end, std::size_t grainSize, T &&procedure
+                   , ThreadPoolLane lane)
+{
+    auto wrapper = [&procedure] (std::size_t, std::size_t first, std::size_t last) -> void {
+        for (std::size_t i = first; i < last && !ThreadPool::CurrentTaskIsCancelled(); ++i) {
+            procedure(i);
+        }
+    };
+
+    executeChunks(begin, end, grainSize, &wrapper, lane);
+}
+
+
+template <class T, class U, class V>
+T
+Async::parallelReduce(std::size_t begin, std::size_t end, std::size_t grainSize, T identity
+                      , U &&mapper, V &&reducer, ThreadPoolLane lane)
+{
+    SIREN_ASSERT(begin <= end);
+    grainSize = std::max(grainSize, std::size_t(1));
+    std::vector<T> values((end - begin + grainSize - 1) / grainSize, identity);
+
+    auto wrapper = [&] (std::size_t chunkIndex, std::size_t first, std::size_t last) -> void {
+        T value = identity;
+
+        for (std::size_t i = first; i < last && !ThreadPool::CurrentTaskIsCancelled(); ++i) {
+            value = reducer(std::move(value), mapper(i));
+        }
+
+        values[chunkIndex] = std::move(value);
+    };
+
+    executeChunks(begin, end, grainSize, &wrapper, lane);
+
+    for (T &value : values) {
+        identity = reducer(std::move(identity), std::move(value));
+    }
+
+    return identity;
+}
+
+
+template <class T>
+void
+Async::executeProcedure(T *procedure, ThreadPoolLane lane)
+{
+    SIREN_ASSERT(isValid());
+
+    struct MyTask
+      : Task
+    {
+        T *procedure;
+
+        static void Execute(ThreadPoolTask *threadPoolTask)
+        {
+            (*static_cast<MyTask *>(threadPoolTask)->procedure)();
+        }
+    } task;
+
+    task.procedure = procedure;
+    ThreadPoolTask *taskPointer = &task;
+    runTasks(&taskPointer, 1, &MyTask::Execute, lane, 1);
+    task.check();
+}
+
+
+
+template <class T>
+void
+Async::executeChunks(std::size_t begin, std::size_t end, std::size_t grainSize, T *procedure
+                     , ThreadPoolLane lane)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(begin <= end);
+    grainSize = std::max(grainSize, std::size_t(1));
+    std::size_t numberOfTasks = (end - begin + grainSize - 1) / grainSize;
+
+    if (numberOfTasks == 0) {
+        return;
+    }
+
+    struct MyTask
+      : Task
+    {
+        T *procedure;
+        std::size_t index;
+        std::size_t begin;
+        std::size_t end;
+
+        static void Execute(ThreadPoolTask *threadPoolTask)
+        {
+            auto task = static_cast<MyTask *>(threadPoolTask);
+            (*task->procedure)(task->index, task->begin, task->end);
+        }
+    };
+
+    std::unique_ptr<MyTask []> myTasks(new MyTask[numberOfTasks]);
+    std::vector<ThreadPoolTask *> tasks(numberOfTasks);
+
+    for (std::size_t i = 0; i < numberOfTasks; ++i) {
+        MyTask *task = &myTasks[i];
+        task->procedure = procedure;
+        task->index = i;
+        task->begin = begin + i * grainSize;
+        task->end = std::min(task->begin + grainSize, end);
+        tasks[i] = task;
+    }
+
+    runTasks(tasks.data(), numberOfTasks, &MyTask::Execute, lane, numberOfTasks);
+    checkTasks(tasks.data(), numberOfTasks);
+}
+
 } // namespace siren
@@ -15,6 +15,11 @@ extern "C" {
 int siren_open(const char *, int, ...) SIREN__NOEXCEPT;
 int siren_fs_open(const char *, int, ...) SIREN__NOEXCEPT;
 int siren_fcntl(int, int, ...) SIREN__NOEXCEPT;
+#    ifdef __USE_GNU
+ssize_t siren_splice(int, loff_t *, int, loff_t *, size_t, unsigned int) SIREN__NOEXCEPT;
+ssize_t siren_tee(int, int, size_t, unsigned int) SIREN__NOEXCEPT;
+int siren_fs_fallocate(int, int, off_t, off_t) SIREN__NOEXCEPT;
+#    endif
 #  endif
 #endif
 
@@ -31,6 +36,10 @@ ssize_t siren_readv(int, const struct iovec *, int) SIREN__NOEXCEPT;
 ssize_t siren_fs_readv(int, const struct iovec *, int) SIREN__NOEXCEPT;
 ssize_t siren_writev(int, const struct iovec *, int) SIREN__NOEXCEPT;
 ssize_t siren_fs_writev(int, const struct iovec *, int) SIREN__NOEXCEPT;
+ssize_t siren_fs_pread(int, void *, size_t, off_t) SIREN__NOEXCEPT;
+ssize_t siren_fs_pwrite(int, const void *, size_t, off_t) SIREN__NOEXCEPT;
+int siren_fs_fsync(int) SIREN__NOEXCEPT;
+int siren_fs_fdatasync(int) SIREN__NOEXCEPT;
 off_t siren_lseek(int, off_t, int) SIREN__NOEXCEPT;
 int siren_close(int) SIREN__NOEXCEPT;
 int siren_fs_close(int) SIREN__NOEXCEPT;
@@ -57,6 +66,10 @@ ssize_t siren_send(int, const void *, size_t, int) SIREN__NOEXCEPT;
 ssize_t siren_recvfrom(int, void *, size_t, int, struct sockaddr *, socklen_t *) SIREN__NOEXCEPT;
 ssize_t siren_sendto(int, const void *, size_t, int, const struct sockaddr *
                      , socklen_t) SIREN__NOEXCEPT;
+#    ifdef __USE_GNU
+int siren_recvmmsg(int, struct mmsghdr *, unsigned int, int, struct timespec *) SIREN__NOEXCEPT;
+int siren_sendmmsg(int, struct mmsghdr *, unsigned int, int) SIREN__NOEXCEPT;
+#    endif
 #  endif
 #endif
 
@@ -74,6 +87,38 @@ int siren_getnameinfo(const struct sockaddr *, socklen_t, char *, socklen_t, cha
 #  ifndef SIREN_C_LIBRARY_H_5
 #    define SIREN_C_LIBRARY_H_5
 int siren_poll(struct pollfd *, nfds_t, int) SIREN__NOEXCEPT;
+#    ifdef __USE_GNU
+int siren_ppoll(struct pollfd *, nfds_t, const struct timespec *, const sigset_t *) SIREN__NOEXCEPT;
+#    endif
+#  endif
+#endif
+
+#ifdef _SYS_SELECT_H
+#  ifndef SIREN_C_LIBRARY_H_6
+#    define SIREN_C_LIBRARY_H_6
+int siren_select(int, fd_set *, fd_set *, fd_set *, struct timeval *) SIREN__NOEXCEPT;
+#  endif
+#endif
+
+#ifdef _SYS_SENDFILE_H
+#  ifndef SIREN_C_LIBRARY_H_7
+#    define SIREN_C_LIBRARY_H_7
+ssize_t siren_sendfile(int, int, off_t *, size_t) SIREN__NOEXCEPT;
+#  endif
+#endif
+
+#ifdef _SYS_UIO_H
+#  ifndef SIREN_C_LIBRARY_H_8
+#    define SIREN_C_LIBRARY_H_8
+ssize_t siren_fs_preadv(int, const struct iovec *, int, off_t) SIREN__NOEXCEPT;
+ssize_t siren_fs_pwritev(int, const struct iovec *, int, off_t) SIREN__NOEXCEPT;
+#  endif
+#endif
+
+#ifdef _SIGNAL_H
+#  ifndef SIREN_C_LIBRARY_H_9
+#    define SIREN_C_LIBRARY_H_9
+int siren_sigwaitinfo(const sigset_t *, siginfo_t *) SIREN__NOEXCEPT;
 #  endif
 #endif
 
@@ -1,6 +1,7 @@
 #pragma once
 
 
+#include <cstdint>
 #include <chrono>
 
 #include "heap.h"
@@ -16,7 +17,8 @@ class IOClock final
 public:
     typedef IOTimer Timer;
 
-    inline std::chrono::milliseconds getDueTime() const noexcept;
+    inline std::chrono::nanoseconds getDueTime() const noexcept;
+    inline std::uint64_t getNumberOfSavedWakeups() const noexcept;
 
     template <class T>
     inline void removeExpiredTimers(T &&);
@@ -29,13 +31,15 @@ public:
     void start() noexcept;
     void stop() noexcept;
     void restart() noexcept;
-    void addTimer(Timer *, std::chrono::milliseconds);
+    void addTimer(Timer *, std::chrono::nanoseconds
+                  , std::chrono::nanoseconds = std::chrono::nanoseconds(0));
     void removeTimer(Timer *) noexcept;
 
 private:
     Heap timerHeap_;
-    std::chrono::milliseconds now_;
+    std::chrono::nanoseconds now_;
     std::chrono::steady_clock::time_point startTime_;
+    std::uint64_t savedWakeupCount_;
 
     void initialize() noexcept;
     void move(IOClock *) noexcept;
@@ -51,7 +55,8 @@ protected:
     ~IOTimer() = default;
 
 private:
-    std::chrono::milliseconds expiryTime_;
+    std::chrono::nanoseconds expiryTime_;
+    std::chrono::nanoseconds deadline_;
 
     static bool OrderHeapNode(const HeapNode *, const HeapNode *) noexcept;
 
@@ -74,18 +79,25 @@ private:
 
 namespace siren {
 
-std::chrono::milliseconds
+std::chrono::nanoseconds
 IOClock::getDueTime() const noexcept
 {
     if (timerHeap_.isEmpty()) {
-        return std::chrono::milliseconds(-1);
+        return std::chrono::nanoseconds(-1);
     } else {
         auto timer = static_cast<const IOTimer *>(timerHeap_.getTop());
-        return std::max(timer->expiryTime_ - now_, std::chrono::milliseconds(0));
+        return std::max(timer->deadline_ - now_, std::chrono::nanoseconds(0));
     }
 }
 
 
+std::uint64_t
+IOClock::getNumberOfSavedWakeups() const noexcept
+{
+    return savedWakeupCount_;
+}
+
+
 template <class T>
 void
 IOClock::removeExpiredTimers(T &&callback)
@@ -94,6 +106,10 @@ IOClock::removeExpiredTimers(T &&callback)
         auto timer = static_cast<Timer *>(timerHeap_.getTop());
 
         if (timer->expiryTime_ <= now_) {
+            if (timer->deadline_ > now_) {
+                ++savedWakeupCount_;
+            }
+
             callback(timer);
             timerHeap_.removeTop();
         } else {
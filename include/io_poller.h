@@ -2,6 +2,7 @@
 
 
 #include <cstddef>
+#include <chrono>
 
 #include <sys/epoll.h>
 
@@ -14,8 +15,9 @@
 
 
 #define SIREN__IO_CONDITIONS ::siren::IOCondition::In, ::siren::IOCondition::Out \
-                             , ::siren::IOCondition::RdHup, ::siren::IOCondition::Pri
-#define SIREN__NUMBER_OF_IO_CONDITIONS 4
+                             , ::siren::IOCondition::RdHup, ::siren::IOCondition::Pri \
+                             , ::siren::IOCondition::Err
+#define SIREN__NUMBER_OF_IO_CONDITIONS 5
 
 
 namespace siren {
@@ -53,6 +55,8 @@ public:
 
     inline bool isValid() const noexcept;
     inline bool contextExists(int) const noexcept;
+    inline std::chrono::nanoseconds getSpinningTime() const noexcept;
+    inline std::chrono::nanoseconds getSleepingTime() const noexcept;
 
     template <class T>
     inline void getReadyWatchers(Clock *, T &&);
@@ -64,6 +68,7 @@ public:
 
     void createContext(int);
     void destroyContext(int) noexcept;
+    void setBusyPollBudget(std::chrono::nanoseconds) noexcept;
     const void *getContextTag(int) const noexcept;
     void *getContextTag(int) noexcept;
     void addWatcher(Watcher *, int, Condition) noexcept;
@@ -73,6 +78,12 @@ private:
     typedef detail::IOContext Context;
 
     int epollFD_;
+    int timerFD_;
+    bool timerFDIsArmed_;
+    std::chrono::nanoseconds busyPollBudget_;
+    std::chrono::nanoseconds currentBusyPollBudget_;
+    std::chrono::nanoseconds spinningTime_;
+    std::chrono::nanoseconds sleepingTime_;
     ObjectPool<Context> contextPool_;
     HashTable contextHashTable_;
     List dirtyContextList_;
@@ -88,6 +99,9 @@ private:
     Context *findContext(int) noexcept;
     void flushContexts();
     std::size_t pollEvents(Clock *);
+    int spinForEvents(std::chrono::nanoseconds);
+    void armTimerFD(std::chrono::nanoseconds) noexcept;
+    int waitForEvents(std::size_t, std::chrono::nanoseconds);
 };
 
 
@@ -156,6 +170,20 @@ IOPoller::contextExists(int fd) const noexcept
 }
 
 
+std::chrono::nanoseconds
+IOPoller::getSpinningTime() const noexcept
+{
+    return spinningTime_;
+}
+
+
+std::chrono::nanoseconds
+IOPoller::getSleepingTime() const noexcept
+{
+    return sleepingTime_;
+}
+
+
 template <class T>
 void
 IOPoller::getReadyWatchers(Clock *clock, T &&callback)
@@ -2,8 +2,16 @@
 
 
 #include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <vector>
 
 #include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/uio.h>
 #include <unistd.h>
@@ -11,6 +19,7 @@
 #include "event.h"
 #include "io_clock.h"
 #include "io_poller.h"
+#include "list.h"
 #include "mutex.h"
 #include "scheduler.h"
 #include "semaphore.h"
@@ -18,7 +27,12 @@
 
 namespace siren {
 
-namespace detail { struct FileOptions; }
+namespace detail {
+
+struct FileOptions;
+struct WriteBuffer;
+
+} // namespace detail
 
 
 class Loop final
@@ -34,7 +48,14 @@ public:
     inline Semaphore makeSemaphore(std::intmax_t = 0, std::intmax_t = 0
                                    , std::intmax_t = std::numeric_limits<std::intmax_t>::max())
         noexcept;
-    inline int usleep(useconds_t);
+    inline std::chrono::nanoseconds getTimerSlack() const noexcept;
+    inline void setTimerSlack(std::chrono::nanoseconds) noexcept;
+    inline std::uint64_t getNumberOfSavedTimerWakeups() const noexcept;
+    inline void setBusyPollBudget(std::chrono::nanoseconds) noexcept;
+    inline void setCPUAffinity(const cpu_set_t &) noexcept;
+    inline std::chrono::nanoseconds getSpinningTime() const noexcept;
+    inline std::chrono::nanoseconds getSleepingTime() const noexcept;
+    inline int usleep(useconds_t, useconds_t = 0);
     inline int pipe(int [2]);
     inline int accept(int, sockaddr *, socklen_t *);
     inline bool fdIsManaged(int) const noexcept;
@@ -43,7 +64,7 @@ public:
 
     void run();
     void manageFD(int);
-    void unmanageFD(int) noexcept;
+    int unmanageFD(int) noexcept;
     int open(const char *, int, mode_t = 0);
     int fcntl(int, int, int = 0) noexcept;
     int pipe2(int [2], int);
@@ -55,20 +76,42 @@ public:
     int getsockopt(int, int, int, void *, socklen_t *) const noexcept;
     int setsockopt(int, int, int, const void *, socklen_t) noexcept;
     int accept4(int, sockaddr *, socklen_t *, int);
+    int acceptMany(int, int *, sockaddr_storage *, int, int = 0);
     int connect(int, const sockaddr *, socklen_t);
     ssize_t recv(int, void *, size_t, int);
     ssize_t send(int, const void *, size_t, int);
     ssize_t recvfrom(int, void *, size_t, int, sockaddr *, socklen_t *);
     ssize_t sendto(int, const void *, size_t, int, const sockaddr *, socklen_t);
+    int recvmmsg(int, mmsghdr *, unsigned int, int, timespec *);
+    int sendmmsg(int, mmsghdr *, unsigned int, int);
+    ssize_t sendfile(int, int, off_t *, size_t);
+    ssize_t splice(int, loff_t *, int, loff_t *, size_t, unsigned int);
+    ssize_t tee(int, int, size_t, unsigned int);
+    // Always releases the fd. Fails with ECOMM if buffered or zero-copy bytes weren't delivered.
     int close(int) noexcept;
     int poll(pollfd *, nfds_t, int);
+    // Signal masks aren't supported: fails with ENOSYS unless the last argument is null.
+    int ppoll(pollfd *, nfds_t, const timespec *, const sigset_t *);
+    int select(int, fd_set *, fd_set *, fd_set *, timeval *);
+    int waitForSignal(const sigset_t *, siginfo_t * = nullptr);
+    int setWriteCoalescing(int, std::size_t);
+    int setZeroCopy(int, std::size_t);
+    int getZeroCopySequenceNumber(int, std::uint32_t *) const noexcept;
+    int waitForZeroCopy(int, std::uint32_t);
+    int flush(int);
 
 private:
     typedef detail::FileOptions FileOptions;
+    typedef detail::WriteBuffer WriteBuffer;
 
     IOClock ioClock_;
     IOPoller ioPoller_;
     Scheduler scheduler_;
+    std::chrono::nanoseconds timerSlack_;
+    cpu_set_t cpuAffinity_;
+    bool hasCPUAffinity_;
+    List dirtyWriteBufferList_;
+    std::size_t numberOfWaitingWriteBuffers_;
 
     const FileOptions *getFileOptions(int) const noexcept;
     FileOptions *getFileOptions(int) noexcept;
@@ -76,14 +119,30 @@ private:
     void destroyIOContext(int) noexcept;
     long getEffectiveReadTimeout(int) const noexcept;
     long getEffectiveWriteTimeout(int) const noexcept;
-    bool waitForFile(int, IOCondition, IOCondition *, std::chrono::milliseconds);
-    void setDelay(std::chrono::milliseconds);
+    bool waitForFile(int, IOCondition, IOCondition *, std::chrono::nanoseconds);
+    int pollFiles(pollfd *, nfds_t, std::chrono::nanoseconds);
+    int createPollSet(const pollfd *, nfds_t, std::vector<pollfd> *);
+    void destroyPollSet(int) noexcept;
+    void waitForFiles(pollfd *, nfds_t, std::chrono::nanoseconds);
+    void setDelay(std::chrono::nanoseconds, std::chrono::nanoseconds);
+    ssize_t bufferFile(WriteBuffer *, long, const iovec *, int);
+    int flushWriteBuffer(WriteBuffer *, long);
+    void flushWriteBuffers() noexcept;
+    void stopWaitingForWriteBuffer(WriteBuffer *) noexcept;
+    int finishWrites(int, long) noexcept;
+    void destroyWriteBuffer(WriteBuffer *) noexcept;
+    ssize_t sendZeroCopy(int, long, const void *, size_t, int);
+    int waitForZeroCopyCompletions(int, std::uint32_t, long);
+    int reapZeroCopyCompletions(int) noexcept;
 
     template <class T, class ...U>
     ssize_t readFile(int, long, T &&, U &&...);
 
     template <class T, class ...U>
     ssize_t writeFile(int, long, T &&, U &&...);
+
+    template <class T, class ...U>
+    ssize_t transferFile(int, int, T &&, U &&...);
 };
 
 } // namespace siren
@@ -162,10 +221,61 @@ Loop::makeSemaphore(std::intmax_t initialValue, std::intmax_t minValue
 }
 
 
+std::chrono::nanoseconds
+Loop::getTimerSlack() const noexcept
+{
+    return timerSlack_;
+}
+
+
+void
+Loop::setTimerSlack(std::chrono::nanoseconds timerSlack) noexcept
+{
+    SIREN_ASSERT(timerSlack.count() >= 0);
+    timerSlack_ = timerSlack;
+}
+
+
+std::uint64_t
+Loop::getNumberOfSavedTimerWakeups() const noexcept
+{
+    return ioClock_.getNumberOfSavedWakeups();
+}
+
+
+void
+Loop::setBusyPollBudget(std::chrono::nanoseconds busyPollBudget) noexcept
+{
+    ioPoller_.setBusyPollBudget(busyPollBudget);
+}
+
+
+void
+Loop::setCPUAffinity(const cpu_set_t &cpuAffinity) noexcept
+{
+    cpuAffinity_ = cpuAffinity;
+    hasCPUAffinity_ = true;
+}
+
+
+std::chrono::nanoseconds
+Loop::getSpinningTime() const noexcept
+{
+    return ioPoller_.getSpinningTime();
+}
+
+
+std::chrono::nanoseconds
+Loop::getSleepingTime() const noexcept
+{
+    return ioPoller_.getSleepingTime();
+}
+
+
 int
-Loop::usleep(useconds_t duration)
+Loop::usleep(useconds_t duration, useconds_t slack)
 {
-    setDelay(std::chrono::milliseconds(duration / 1000));
+    setDelay(std::chrono::microseconds(duration), std::chrono::microseconds(slack));
     return 0;
 }
 
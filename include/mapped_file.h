@@ -0,0 +1,63 @@
+#pragma once
+
+
+#include <cstddef>
+
+
+namespace siren {
+
+class Async;
+
+
+class MappedFile final
+{
+public:
+    inline const void *getData(std::size_t = 0) const noexcept;
+    inline std::size_t getSize() const noexcept;
+
+    explicit MappedFile(const char *);
+    MappedFile(MappedFile &&) noexcept;
+    ~MappedFile();
+    MappedFile &operator=(MappedFile &&) noexcept;
+
+    bool isResident(std::size_t, std::size_t) const;
+    void prefetch(Async *, std::size_t, std::size_t);
+
+private:
+    void *data_;
+    std::size_t size_;
+
+    void initialize(const char *);
+    void finalize() noexcept;
+    void move(MappedFile *) noexcept;
+    bool getPageRange(std::size_t, std::size_t, char **, std::size_t *) const noexcept;
+};
+
+} // namespace siren
+
+
+/*
+ * #include "mapped_file-inl.h"
+ */
+
+
+#include "assert.h"
+
+
+namespace siren {
+
+const void *
+MappedFile::getData(std::size_t offset) const noexcept
+{
+    SIREN_ASSERT(offset <= size_);
+    return static_cast<const char *>(data_) + offset;
+}
+
+
+std::size_t
+MappedFile::getSize() const noexcept
+{
+    return size_;
+}
+
+} // namespace siren
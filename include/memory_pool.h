@@ -12,6 +12,8 @@ class MemoryPool final
 public:
     inline void *allocateBlock();
     inline void freeBlock(void *) noexcept;
+    inline bool isNUMALocal() const noexcept;
+    inline void setNUMALocal(bool) noexcept;
 
     explicit MemoryPool(std::size_t, std::size_t, std::size_t = 0) noexcept;
     MemoryPool(MemoryPool &&) noexcept;
@@ -25,6 +27,7 @@ private:
     const std::size_t blockSize_;
     const std::size_t minChunkSize_;
     std::vector<void *> chunks_;
+    bool isNUMALocal_;
     std::size_t nextChunkSize_;
     void *lastNewBlock_;
     void *firstNewBlock_;
@@ -37,6 +40,8 @@ private:
     void finalize() noexcept;
     void move(MemoryPool *) noexcept;
     void *makeBlock();
+    void *allocateChunk(std::size_t);
+    void freeChunk(void *, std::size_t) noexcept;
 };
 
 } // namespace siren
@@ -91,4 +96,19 @@ MemoryPool::freeBlock(void *block) noexcept
     lastFreeBlock_ = block;
 }
 
+
+bool
+MemoryPool::isNUMALocal() const noexcept
+{
+    return isNUMALocal_;
+}
+
+
+void
+MemoryPool::setNUMALocal(bool isNUMALocal) noexcept
+{
+    SIREN_ASSERT(chunks_.empty());
+    isNUMALocal_ = isNUMALocal;
+}
+
 } // namespace siren
@@ -5,4 +5,4 @@
 
 
 #define SIREN_OUTPUT_STRING(X) \
-    (static_cast<std::stringstream &&>(std::ostringstream() << X).str())
+    (static_cast<std::ostringstream &&>(std::ostringstream() << X).str())
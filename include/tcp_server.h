@@ -0,0 +1,68 @@
+#pragma once
+
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "ip_endpoint.h"
+
+
+namespace siren {
+
+class Loop;
+class TCPSocket;
+namespace detail { struct TCPServerWorker; }
+
+
+class TCPServer final
+{
+public:
+    typedef std::function<void (Loop *, TCPSocket, IPEndpoint)> Handler;
+    typedef std::function<void (Loop *, IPEndpoint, std::exception_ptr)> ErrorHandler;
+
+    inline const IPEndpoint &getLocalEndpoint() const noexcept;
+
+    explicit TCPServer(const IPEndpoint &, const Handler &, std::size_t = 0, int = 511
+                       , const ErrorHandler & = nullptr, std::size_t = 0);
+    ~TCPServer();
+
+    void stop() noexcept;
+
+private:
+    typedef detail::TCPServerWorker Worker;
+
+    Handler handler_;
+    ErrorHandler errorHandler_;
+    IPEndpoint localEndpoint_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    void finalize() noexcept;
+    void start(const IPEndpoint &, std::size_t, int, std::size_t);
+    void worker(Worker *) noexcept;
+
+    TCPServer(const TCPServer &) = delete;
+    TCPServer &operator=(const TCPServer &) = delete;
+};
+
+} // namespace siren
+
+
+/*
+ * #include "tcp_server-inl.h"
+ */
+
+
+namespace siren {
+
+const IPEndpoint &
+TCPServer::getLocalEndpoint() const noexcept
+{
+    return localEndpoint_;
+}
+
+} // namespace siren
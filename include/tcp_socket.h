@@ -2,6 +2,11 @@
 
 
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <sys/types.h>
 
 #include "ip_endpoint.h"
 
@@ -24,6 +29,7 @@ public:
     TCPSocket &operator=(TCPSocket &&) noexcept;
 
     void setReuseAddress(bool);
+    void setReusePort(bool);
     void setNoDelay(bool);
     void setLinger(bool, int);
     void setKeepAlive(bool, int);
@@ -31,8 +37,16 @@ public:
     void setSendTimeout(long);
     void setReceiveBufferSize(int);
     void setSendBufferSize(int);
+    void setWriteCoalescing(std::size_t);
+    void setZeroCopy(std::size_t);
+    std::uint32_t getZeroCopySequenceNumber() const;
+    void waitForZeroCopy(std::uint32_t);
     void listen(const IPEndpoint &, int = 511);
     TCPSocket accept(IPEndpoint * = nullptr);
+    std::size_t acceptMany(std::vector<TCPSocket> *, std::vector<IPEndpoint> * = nullptr
+                           , std::size_t = 64);
+    void serve(const std::function<void (TCPSocket, IPEndpoint)> &, std::size_t = 64
+               , std::size_t = 0);
     void connect(const IPEndpoint &);
     IPEndpoint getLocalEndpoint() const;
     IPEndpoint getRemoteEndpoint() const;
@@ -40,6 +54,9 @@ public:
     std::size_t write(const void *, std::size_t);
     std::size_t read(Stream *);
     std::size_t write(Stream *);
+    void flush();
+    std::size_t sendFile(int, off_t *, std::size_t);
+    std::size_t relay(TCPSocket *);
     void closeRead();
     void closeWrite();
 
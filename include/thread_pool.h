@@ -2,14 +2,18 @@
 
 
 #include <cstddef>
+#include <cstdint>
 #include <atomic>
-#include <condition_variable>
+#include <chrono>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <type_traits>
 #include <vector>
 
+#include <sched.h>
+
 #include "config.h"
 #include "list.h"
 
@@ -17,7 +21,22 @@
 namespace siren {
 
 class ThreadPool;
-namespace detail { enum class ThreadPoolTaskState; }
+
+namespace detail {
+
+enum class ThreadPoolTaskState;
+struct ThreadPoolSlot;
+struct ThreadPoolQueue;
+struct ThreadPoolWorker;
+
+} // namespace detail
+
+
+enum class ThreadPoolLane
+{
+    Interactive = 0,
+    Bulk,
+};
 
 
 class ThreadPoolTask
@@ -35,7 +54,12 @@ private:
     typedef detail::ThreadPoolTaskState State;
 
     std::atomic<State> state_;
-    bool isWaiting_;
+    std::atomic<bool> isCancelled_;
+    std::size_t sequenceNumber_;
+    bool isForked_;
+    ThreadPoolLane lane_;
+    ThreadPoolTask *nextCompletedTask_;
+    void (*function_)(ThreadPoolTask *);
     std::function<void ()> procedure_;
     std::exception_ptr exception_;
 
@@ -51,41 +75,108 @@ class ThreadPool final
 public:
     typedef ThreadPoolTask Task;
 
+    static bool CurrentTaskIsCancelled() noexcept;
+
     inline int getEventFD() const noexcept;
+    inline std::size_t getNumberOfThreads() const noexcept;
+    inline std::size_t getNumberOfActiveThreads() const noexcept;
+    inline std::uint64_t getNumberOfSpawnFailures() const noexcept;
+    inline void setSpawnDelay(std::chrono::microseconds) noexcept;
+    inline void setIdleTimeout(std::chrono::milliseconds) noexcept;
+    inline void setNumberOfReservedThreads(std::size_t) noexcept;
+
+    // addTask() and addTasks() throw std::system_error (EAGAIN) if the queue is full.
+    template <class T>
+    inline std::enable_if_t<!std::is_same<T, nullptr_t>::value, void>
+        addTask(Task *, T &&, ThreadPoolLane = ThreadPoolLane::Interactive);
+
+    inline void addTask(Task *, void (*)(Task *), ThreadPoolLane = ThreadPoolLane::Interactive);
+    inline void addTasks(Task *const *, std::size_t, void (*)(Task *)
+                         , ThreadPoolLane = ThreadPoolLane::Interactive);
+    inline std::size_t tryAddTasks(Task *const *, std::size_t, void (*)(Task *)
+                                   , ThreadPoolLane = ThreadPoolLane::Interactive);
 
     template <class T>
-    inline std::enable_if_t<!std::is_same<T, nullptr_t>::value, void> addTask(Task *, T &&);
+    inline std::enable_if_t<!std::is_same<T, nullptr_t>::value, void> forkTask(Task *, T &&);
 
     template <class T>
     void removeCompletedTasks(T &&);
 
-    explicit ThreadPool(std::size_t = 0);
+    explicit ThreadPool(std::size_t = 0, std::size_t = 0, std::size_t = 0);
     ~ThreadPool();
 
+    std::uint64_t getNumberOfDequeuedTasks() const noexcept;
+    std::chrono::nanoseconds getTotalQueueLatency() const noexcept;
+    void setCPUAffinity(const cpu_set_t &);
     void removeTask(Task *, bool *) noexcept;
+    bool cancelTask(Task *) noexcept;
+    void joinTask(Task *);
 
 private:
     typedef detail::ThreadPoolTaskState TaskState;
-
-    Task noListNode_;
-    List waitingTaskList_;
+    typedef detail::ThreadPoolSlot Slot;
+    typedef detail::ThreadPoolQueue Queue;
+    typedef detail::ThreadPoolWorker Worker;
+    typedef ThreadPoolLane Lane;
+
+    std::unique_ptr<Queue []> queues_;
+    std::atomic<std::size_t> numberOfBulkThreads_;
+    std::atomic<std::size_t> numberOfReservedThreads_;
+    std::atomic<std::uint32_t> wakeupCount_;
+    std::atomic<int> numberOfSleepingThreads_;
+    std::atomic<std::uint32_t> taskWakeupCount_;
+    std::atomic<int> numberOfTaskWaiters_;
+    std::atomic<std::uint32_t> monitorWakeupCount_;
+    std::atomic<bool> monitorIsIdle_;
+    std::atomic<bool> isStopped_;
+    std::atomic<Task *> completedTaskStack_;
     List completedTaskList_;
     int eventFD_;
-    std::mutex mutexes_[2];
-    std::condition_variable conditionVariable_;
+    std::unique_ptr<Worker []> workers_;
+    std::size_t numberOfWorkers_;
+    std::size_t minNumberOfThreads_;
+    std::atomic<std::size_t> numberOfThreads_;
+    std::atomic<std::int64_t> spawnDelay_;
+    std::atomic<long> idleTimeout_;
+    std::atomic<std::int64_t> lastSpawnTime_;
+    std::atomic<std::uint64_t> numberOfSpawnFailures_;
+    std::mutex mutex_;
     std::vector<std::thread> threads_;
+    std::thread monitorThread_;
+    cpu_set_t cpuAffinity_;
+    bool hasCPUAffinity_;
 
-    void initialize();
+    void initialize(std::size_t);
     void finalize() noexcept;
-    void start(std::size_t);
+    void start(std::size_t, std::size_t);
     void stop() noexcept;
-    void worker() noexcept;
+    void spawnThread();
+    void adjustNumberOfThreads() noexcept;
+    bool retireThread() noexcept;
+    void monitor() noexcept;
+    bool hasWaitingTasks() const noexcept;
+    void worker(Worker *) noexcept;
+    void executeTask(Task *) noexcept;
     void addWaitingTask(Task *);
+    void addWaitingTasks(Task *const *, std::size_t);
+    std::size_t tryAddWaitingTasks(Task *const *, std::size_t, std::size_t) noexcept;
     bool removeWaitingTask(Task *) noexcept;
-    Task *removeWaitingTask() noexcept;
+    Task *removeWaitingTask(Worker *) noexcept;
+    Task *tryRemoveWaitingTask(Worker *, Queue *) noexcept;
+    Task *tryRemoveBulkTask(Worker *) noexcept;
+    Task *findTask(Worker *) noexcept;
+    void addForkedTask(Task *);
+    Task *removeForkedTask(Worker *) noexcept;
+    Task *stealForkedTask(Worker *) noexcept;
+    void wakeThreads(std::size_t) noexcept;
+    bool waitForWakeup(long) noexcept;
+    bool unregisterSleepingThread() noexcept;
+    void wakeTaskWaiters() noexcept;
+    void waitForTask(Task *) noexcept;
     void noMoreWaitingTasks();
-    void addCompletedTask(Task *);
+    bool addCompletedTask(Task *) noexcept;
     void removeCompletedTask(Task *) noexcept;
+    void takeCompletedTasks() noexcept;
 
     ThreadPool(const ThreadPool &) = delete;
     ThreadPool &operator=(const ThreadPool &) = delete;
@@ -118,6 +209,37 @@ enum class ThreadPoolTaskState
     Completed,
 };
 
+
+struct ThreadPoolSlot
+{
+    std::atomic<std::size_t> sequenceNumber;
+    std::atomic<ThreadPoolTask *> task;
+    std::atomic<std::int64_t> enqueueTime;
+};
+
+
+struct ThreadPoolQueue
+{
+    std::unique_ptr<ThreadPoolSlot []> slots;
+    std::size_t slotIndexMask;
+    std::atomic<std::size_t> enqueuePosition;
+    std::atomic<std::size_t> dequeuePosition;
+};
+
+
+struct ThreadPoolWorker
+{
+    ThreadPool *threadPool;
+    std::atomic<std::ptrdiff_t> top;
+    std::atomic<std::ptrdiff_t> bottom;
+    std::unique_ptr<std::atomic<ThreadPoolTask *> []> slots;
+    std::size_t slotIndexMask;
+    std::uint32_t randomNumber;
+    std::atomic<bool> isAlive;
+    std::atomic<std::uint64_t> numberOfDequeuedTasks;
+    std::atomic<std::uint64_t> queueLatency;
+};
+
 } // namespace detail
 
 
@@ -137,33 +259,149 @@ ThreadPool::getEventFD() const noexcept
 }
 
 
+std::size_t
+ThreadPool::getNumberOfThreads() const noexcept
+{
+    return numberOfThreads_.load(std::memory_order_relaxed);
+}
+
+
+std::size_t
+ThreadPool::getNumberOfActiveThreads() const noexcept
+{
+    std::size_t numberOfThreads = numberOfThreads_.load(std::memory_order_relaxed);
+    std::size_t numberOfSleepingThreads = numberOfSleepingThreads_.load(std::memory_order_relaxed);
+    return numberOfThreads > numberOfSleepingThreads ? numberOfThreads - numberOfSleepingThreads : 0;
+}
+
+
+std::uint64_t
+ThreadPool::getNumberOfSpawnFailures() const noexcept
+{
+    return numberOfSpawnFailures_.load(std::memory_order_relaxed);
+}
+
+
+void
+ThreadPool::setSpawnDelay(std::chrono::microseconds spawnDelay) noexcept
+{
+    spawnDelay_.store(std::chrono::nanoseconds(spawnDelay).count(), std::memory_order_relaxed);
+}
+
+
+void
+ThreadPool::setIdleTimeout(std::chrono::milliseconds idleTimeout) noexcept
+{
+    idleTimeout_.store(idleTimeout.count(), std::memory_order_relaxed);
+}
+
+
+void
+ThreadPool::setNumberOfReservedThreads(std::size_t numberOfReservedThreads) noexcept
+{
+    numberOfReservedThreads_.store(numberOfReservedThreads, std::memory_order_relaxed);
+}
+
+
 template <class T>
 std::enable_if_t<!std::is_same<T, nullptr_t>::value, void>
-ThreadPool::addTask(Task *task, T &&procedure)
+ThreadPool::addTask(Task *task, T &&procedure, Lane lane)
 {
     SIREN_ASSERT(task != nullptr);
     SIREN_ASSERT(task->state_.load(std::memory_order_relaxed) == TaskState::Initial);
     task->state_.store(TaskState::Uncompleted, std::memory_order_relaxed);
+    task->isCancelled_.store(false, std::memory_order_relaxed);
+    task->isForked_ = false;
+    task->lane_ = lane;
+    task->function_ = nullptr;
     task->procedure_ = std::forward<T>(procedure);
     addWaitingTask(task);
 }
 
 
-template <class T>
 void
-ThreadPool::removeCompletedTasks(T &&callback)
+ThreadPool::addTask(Task *task, void (*function)(Task *), Lane lane)
 {
-    List list;
+    SIREN_ASSERT(task != nullptr);
+    SIREN_ASSERT(function != nullptr);
+    SIREN_ASSERT(task->state_.load(std::memory_order_relaxed) == TaskState::Initial);
+    task->state_.store(TaskState::Uncompleted, std::memory_order_relaxed);
+    task->isCancelled_.store(false, std::memory_order_relaxed);
+    task->isForked_ = false;
+    task->lane_ = lane;
+    task->function_ = function;
+    addWaitingTask(task);
+}
 
-    {
-        std::lock_guard<std::mutex> lockGuard(mutexes_[1]);
-        list = std::move(completedTaskList_);
+
+void
+ThreadPool::addTasks(Task *const *tasks, std::size_t numberOfTasks, void (*function)(Task *)
+                     , Lane lane)
+{
+    SIREN_ASSERT(tasks != nullptr || numberOfTasks == 0);
+    SIREN_ASSERT(function != nullptr);
+
+    for (std::size_t i = 0; i < numberOfTasks; ++i) {
+        Task *task = tasks[i];
+        SIREN_ASSERT(task != nullptr);
+        SIREN_ASSERT(task->state_.load(std::memory_order_relaxed) == TaskState::Initial);
+        task->state_.store(TaskState::Uncompleted, std::memory_order_relaxed);
+        task->isCancelled_.store(false, std::memory_order_relaxed);
+        task->isForked_ = false;
+        task->lane_ = lane;
+        task->function_ = function;
     }
 
+    addWaitingTasks(tasks, numberOfTasks);
+}
+
+
+std::size_t
+ThreadPool::tryAddTasks(Task *const *tasks, std::size_t numberOfTasks, void (*function)(Task *)
+                        , Lane lane)
+{
+    SIREN_ASSERT(tasks != nullptr || numberOfTasks == 0);
+    SIREN_ASSERT(function != nullptr);
+
+    for (std::size_t i = 0; i < numberOfTasks; ++i) {
+        Task *task = tasks[i];
+        SIREN_ASSERT(task != nullptr);
+        SIREN_ASSERT(task->state_.load(std::memory_order_relaxed) == TaskState::Initial);
+        task->state_.store(TaskState::Uncompleted, std::memory_order_relaxed);
+        task->isCancelled_.store(false, std::memory_order_relaxed);
+        task->isForked_ = false;
+        task->lane_ = lane;
+        task->function_ = function;
+    }
+
+    return tryAddWaitingTasks(tasks, 1, numberOfTasks);
+}
+
+
+template <class T>
+std::enable_if_t<!std::is_same<T, nullptr_t>::value, void>
+ThreadPool::forkTask(Task *task, T &&procedure)
+{
+    SIREN_ASSERT(task != nullptr);
+    SIREN_ASSERT(task->state_.load(std::memory_order_relaxed) == TaskState::Initial);
+    task->state_.store(TaskState::Uncompleted, std::memory_order_relaxed);
+    task->isCancelled_.store(false, std::memory_order_relaxed);
+    task->isForked_ = true;
+    task->function_ = nullptr;
+    task->procedure_ = std::forward<T>(procedure);
+    addForkedTask(task);
+}
+
+
+template <class T>
+void
+ThreadPool::removeCompletedTasks(T &&callback)
+{
+    takeCompletedTasks();
+    List list(std::move(completedTaskList_));
     Task *task;
 
     auto scopeGuard = MakeScopeGuard([&] () -> void {
-        std::lock_guard<std::mutex> lockGuard(mutexes_[1]);
         completedTaskList_.prependNodes(list.getHead(), task);
     });
 
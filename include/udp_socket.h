@@ -0,0 +1,79 @@
+#pragma once
+
+
+#include <cstddef>
+
+#include "ip_endpoint.h"
+
+
+namespace siren {
+
+class Loop;
+
+
+struct UDPDatagram
+{
+    void *data;
+    std::size_t dataSize;
+    IPEndpoint endpoint;
+};
+
+
+class UDPSocket final
+{
+public:
+    inline bool isValid() const noexcept;
+    inline int getFD() const noexcept;
+
+    explicit UDPSocket(Loop *);
+    UDPSocket(UDPSocket &&) noexcept;
+    ~UDPSocket();
+    UDPSocket &operator=(UDPSocket &&) noexcept;
+
+    void setReuseAddress(bool);
+    void setReceiveTimeout(long);
+    void setSendTimeout(long);
+    void setReceiveBufferSize(int);
+    void setSendBufferSize(int);
+    void bind(const IPEndpoint &);
+    void connect(const IPEndpoint &);
+    IPEndpoint getLocalEndpoint() const;
+    IPEndpoint getRemoteEndpoint() const;
+    std::size_t receiveFrom(void *, std::size_t, IPEndpoint * = nullptr);
+    std::size_t sendTo(const void *, std::size_t, const IPEndpoint &);
+    std::size_t receiveMany(UDPDatagram *, std::size_t);
+    std::size_t sendMany(const UDPDatagram *, std::size_t);
+
+private:
+    Loop *loop_;
+    int fd_;
+
+    void initialize();
+    void finalize() noexcept;
+    void move(UDPSocket *) noexcept;
+};
+
+} // namespace siren
+
+
+/*
+ * #include "udp_socket-inl.h"
+ */
+
+
+namespace siren {
+
+bool
+UDPSocket::isValid() const noexcept
+{
+    return fd_ >= 0;
+}
+
+
+int
+UDPSocket::getFD() const noexcept
+{
+    return fd_;
+}
+
+} // namespace siren
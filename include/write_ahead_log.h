@@ -0,0 +1,110 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "event.h"
+#include "stream.h"
+
+
+namespace siren {
+
+class Async;
+class Loop;
+namespace detail { struct WriteAheadLogGroup; }
+
+
+class WriteAheadLog final
+{
+public:
+    template <class T>
+    inline void append(const T &);
+
+    template <class T, class U>
+    inline void replay(U &&);
+
+    explicit WriteAheadLog(Loop *, Async *, const std::string &, std::size_t = 1024 * 1024
+                           , std::chrono::microseconds = std::chrono::microseconds(0)
+                           , std::size_t = 64 * 1024 * 1024);
+    ~WriteAheadLog();
+
+    void append(const void *, std::size_t);
+    void replay(const std::function<void (const void *, std::size_t)> &);
+
+private:
+    typedef detail::WriteAheadLogGroup Group;
+
+    static std::vector<std::uint64_t> ListSegmentNumbers(const std::string &);
+    static std::string MakeSegmentFileName(const std::string &, std::uint64_t);
+
+    Loop *loop_;
+    Async *async_;
+    std::string directoryName_;
+    std::size_t maxBatchSize_;
+    std::chrono::microseconds maxBatchDelay_;
+    std::size_t maxSegmentSize_;
+    Stream pendingData_;
+    std::shared_ptr<Group> pendingGroup_;
+    Event writerEvent_;
+    Event writerExitEvent_;
+    void *writerFiberHandle_;
+    int segmentFD_;
+    std::size_t segmentSize_;
+
+    void writeRecords() noexcept;
+    void flushRecords(Stream *);
+    void openSegment();
+    void closeSegment() noexcept;
+
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+};
+
+} // namespace siren
+
+
+/*
+ * #include "write_ahead_log-inl.h"
+ */
+
+
+#include <utility>
+
+#include "archive.h"
+
+
+namespace siren {
+
+template <class T>
+void
+WriteAheadLog::append(const T &record)
+{
+    Stream stream;
+    Archive archive(&stream);
+    archive << record;
+    stream.commitBuffer(archive.getNumberOfPreWrittenBytes());
+    append(stream.getData(), stream.getDataSize());
+}
+
+
+template <class T, class U>
+void
+WriteAheadLog::replay(U &&callback)
+{
+    replay([&callback] (const void *data, std::size_t dataSize) -> void {
+        Stream stream;
+        stream.write(data, dataSize);
+        Archive archive(&stream);
+        T record;
+        archive >> record;
+        callback(std::move(record));
+    });
+}
+
+} // namespace siren
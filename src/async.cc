@@ -1,9 +1,13 @@
 #include "async.h"
 
+#include <cerrno>
 #include <cstdint>
 #include <cstdio>
 #include <exception>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include "assert.h"
 #include "event.h"
 #include "loop.h"
@@ -14,17 +18,24 @@ namespace siren {
 
 namespace detail {
 
-struct AsyncTask
-  : ThreadPoolTask
+struct AsyncBatchTask
+  : AsyncTask
 {
-    Event *event;
+    const std::function<void ()> *procedure;
 };
 
 } // namespace detail
 
 
+namespace {
+
+void ExecuteBatchTask(ThreadPoolTask *);
+
+} // namespace
+
+
 void
-Async::EventTrigger(ThreadPool *threadPool, Loop *loop) noexcept
+Async::EventTrigger(ThreadPool *threadPool, Event *queueEvent, Loop *loop) noexcept
 {
     for (;;) {
         try {
@@ -40,16 +51,25 @@ Async::EventTrigger(ThreadPool *threadPool, Loop *loop) noexcept
 
         threadPool->removeCompletedTasks([] (ThreadPoolTask *threadPoolTask) -> void {
             auto task = static_cast<Task *>(threadPoolTask);
-            task->event->trigger();
+            task->isCompleted = true;
+
+            if (--*task->numberOfTasksToWaitFor == 0) {
+                task->event->trigger();
+            }
         });
+
+        queueEvent->trigger();
     }
 }
 
 
-Async::Async(Loop *loop, std::size_t numberOfThreads)
-  : threadPool_(std::make_unique<ThreadPool>(numberOfThreads)),
+Async::Async(Loop *loop, std::size_t minNumberOfThreads, std::size_t maxNumberOfThreads)
+  : threadPool_(std::make_unique<ThreadPool>(minNumberOfThreads, 0, maxNumberOfThreads)),
+    queueEvent_(std::make_unique<Event>(loop->makeEvent())),
     loop_(loop),
-    taskCount_(0)
+    taskCount_(0),
+    numberOfNoWaitHits_(0),
+    numberOfNoWaitMisses_(0)
 {
     SIREN_ASSERT(loop != nullptr);
     initialize();
@@ -58,8 +78,11 @@ Async::Async(Loop *loop, std::size_t numberOfThreads)
 
 Async::Async(Async &&other) noexcept
   : threadPool_(std::move(other.threadPool_)),
+    queueEvent_(std::move(other.queueEvent_)),
     loop_(other.loop_),
-    taskCount_(0)
+    taskCount_(0),
+    numberOfNoWaitHits_(other.numberOfNoWaitHits_),
+    numberOfNoWaitMisses_(other.numberOfNoWaitMisses_)
 {
     SIREN_ASSERT(other.taskCount_ == 0);
     other.move(this);
@@ -81,7 +104,10 @@ Async::operator=(Async &&other) noexcept
         SIREN_ASSERT(other.taskCount_ == 0);
         finalize();
         threadPool_ = std::move(other.threadPool_);
+        queueEvent_ = std::move(other.queueEvent_);
         loop_ = other.loop_;
+        numberOfNoWaitHits_ = other.numberOfNoWaitHits_;
+        numberOfNoWaitMisses_ = other.numberOfNoWaitMisses_;
         other.move(this);
     }
 
@@ -98,7 +124,8 @@ Async::initialize()
         loop_->unmanageFD(threadPool_->getEventFD());
     });
 
-    fiberHandle_ = loop_->createFiber(std::bind(EventTrigger, threadPool_.get(), loop_), 0, true);
+    fiberHandle_ = loop_->createFiber(std::bind(EventTrigger, threadPool_.get(), queueEvent_.get()
+                                                   , loop_), 0, true);
     scopeGuard.dismiss();
 }
 
@@ -122,51 +149,363 @@ Async::move(Async *other) noexcept
 
 
 void
-Async::executeTask(const std::function<void ()> &procedure)
+Async::executeTask(const std::function<void ()> &procedure, ThreadPoolLane lane)
 {
-    SIREN_ASSERT(isValid());
     SIREN_ASSERT(procedure != nullptr);
-    Task task;
-    threadPool_->addTask(&task, procedure);
-    waitForTask(&task);
-    task.check();
+    executeProcedure(&procedure, lane);
 }
 
 
 void
-Async::executeTask(std::function<void ()> &&procedure)
+Async::executeTask(std::function<void ()> &&procedure, ThreadPoolLane lane)
 {
-    SIREN_ASSERT(isValid());
     SIREN_ASSERT(procedure != nullptr);
-    Task task;
-    threadPool_->addTask(&task, std::move(procedure));
-    waitForTask(&task);
-    task.check();
+    executeProcedure(&procedure, lane);
+}
+
+
+std::vector<std::exception_ptr>
+Async::executeTasks(const std::vector<std::function<void ()>> &procedures, ThreadPoolLane lane)
+{
+    SIREN_ASSERT(isValid());
+    std::size_t numberOfTasks = procedures.size();
+    std::vector<std::exception_ptr> exceptions(numberOfTasks);
+
+    if (numberOfTasks == 0) {
+        return exceptions;
+    }
+
+    std::unique_ptr<detail::AsyncBatchTask []> batchTasks(new detail::AsyncBatchTask[numberOfTasks]);
+    std::vector<ThreadPoolTask *> tasks(numberOfTasks);
+
+    for (std::size_t i = 0; i < numberOfTasks; ++i) {
+        SIREN_ASSERT(procedures[i] != nullptr);
+        batchTasks[i].procedure = &procedures[i];
+        tasks[i] = &batchTasks[i];
+    }
+
+    runTasks(tasks.data(), numberOfTasks, ExecuteBatchTask, lane, numberOfTasks);
+
+    for (std::size_t i = 0; i < numberOfTasks; ++i) {
+        try {
+            tasks[i]->check();
+        } catch (...) {
+            exceptions[i] = std::current_exception();
+        }
+    }
+
+    return exceptions;
+}
+
+
+std::size_t
+Async::executeAnyTask(const std::vector<std::function<void ()>> &procedures, ThreadPoolLane lane)
+{
+    SIREN_ASSERT(isValid());
+    std::size_t numberOfTasks = procedures.size();
+    SIREN_ASSERT(numberOfTasks >= 1);
+    std::unique_ptr<detail::AsyncBatchTask []> batchTasks(new detail::AsyncBatchTask[numberOfTasks]);
+    std::vector<ThreadPoolTask *> tasks(numberOfTasks);
+
+    for (std::size_t i = 0; i < numberOfTasks; ++i) {
+        SIREN_ASSERT(procedures[i] != nullptr);
+        batchTasks[i].procedure = &procedures[i];
+        tasks[i] = &batchTasks[i];
+    }
+
+    runTasks(tasks.data(), numberOfTasks, ExecuteBatchTask, lane, 1);
+    std::size_t taskIndex = 0;
+
+    while (!batchTasks[taskIndex].isCompleted) {
+        ++taskIndex;
+    }
+
+    cancelTasks(tasks.data(), numberOfTasks);
+
+    for (std::size_t i = 0; i < numberOfTasks; ++i) {
+        if (i != taskIndex && batchTasks[i].isCompleted) {
+            try {
+                tasks[i]->check();
+            } catch (...) {
+            }
+        }
+    }
+
+    tasks[taskIndex]->check();
+    return taskIndex;
+}
+
+
+ssize_t
+Async::read(int fd, void *buffer, size_t bufferSize)
+{
+    iovec vector = {buffer, bufferSize};
+
+    return transferFile([&] () -> ssize_t {
+        return preadv2(fd, &vector, 1, -1, RWF_NOWAIT);
+    }, [&] () -> ssize_t {
+        return callFunction(::read, fd, buffer, bufferSize);
+    });
+}
+
+
+ssize_t
+Async::write(int fd, const void *data, size_t dataSize)
+{
+    iovec vector = {const_cast<void *>(data), dataSize};
+
+    return transferFile([&] () -> ssize_t {
+        return pwritev2(fd, &vector, 1, -1, RWF_NOWAIT);
+    }, [&] () -> ssize_t {
+        return callFunction(::write, fd, data, dataSize);
+    });
+}
+
+
+ssize_t
+Async::readv(int fd, const iovec *vector, int vectorLength)
+{
+    return transferFile([&] () -> ssize_t {
+        return preadv2(fd, vector, vectorLength, -1, RWF_NOWAIT);
+    }, [&] () -> ssize_t {
+        return callFunction(::readv, fd, vector, vectorLength);
+    });
+}
+
+
+ssize_t
+Async::writev(int fd, const iovec *vector, int vectorLength)
+{
+    return transferFile([&] () -> ssize_t {
+        return pwritev2(fd, vector, vectorLength, -1, RWF_NOWAIT);
+    }, [&] () -> ssize_t {
+        return callFunction(::writev, fd, vector, vectorLength);
+    });
+}
+
+
+ssize_t
+Async::pread(int fd, void *buffer, size_t bufferSize, off_t offset)
+{
+    iovec vector = {buffer, bufferSize};
+
+    return transferFile([&] () -> ssize_t {
+        return preadv2(fd, &vector, 1, offset, RWF_NOWAIT);
+    }, [&] () -> ssize_t {
+        return callFunction(::pread, fd, buffer, bufferSize, offset);
+    });
+}
+
+
+ssize_t
+Async::pwrite(int fd, const void *data, size_t dataSize, off_t offset)
+{
+    iovec vector = {const_cast<void *>(data), dataSize};
+
+    return transferFile([&] () -> ssize_t {
+        return pwritev2(fd, &vector, 1, offset, RWF_NOWAIT);
+    }, [&] () -> ssize_t {
+        return callFunction(::pwrite, fd, data, dataSize, offset);
+    });
+}
+
+
+ssize_t
+Async::preadv(int fd, const iovec *vector, int vectorLength, off_t offset)
+{
+    return transferFile([&] () -> ssize_t {
+        return preadv2(fd, vector, vectorLength, offset, RWF_NOWAIT);
+    }, [&] () -> ssize_t {
+        return callFunction(::preadv, fd, vector, vectorLength, offset);
+    });
+}
+
+
+ssize_t
+Async::pwritev(int fd, const iovec *vector, int vectorLength, off_t offset)
+{
+    return transferFile([&] () -> ssize_t {
+        return pwritev2(fd, vector, vectorLength, offset, RWF_NOWAIT);
+    }, [&] () -> ssize_t {
+        return callFunction(::pwritev, fd, vector, vectorLength, offset);
+    });
+}
+
+
+int
+Async::fsync(int fd)
+{
+    return callFunction(::fsync, fd);
+}
+
+
+int
+Async::fdatasync(int fd)
+{
+    return callFunction(::fdatasync, fd);
+}
+
+
+int
+Async::fallocate(int fd, int mode, off_t offset, off_t length)
+{
+    return callFunction(::fallocate, fd, mode, offset, length);
+}
+
+
+template <class T, class U>
+ssize_t
+Async::transferFile(T &&function1, U &&function2)
+{
+    ssize_t numberOfBytes;
+
+    do {
+        numberOfBytes = function1();
+    } while (numberOfBytes < 0 && errno == EINTR);
+
+    if (numberOfBytes >= 0) {
+        ++numberOfNoWaitHits_;
+        return numberOfBytes;
+    }
+
+    if (errno != EAGAIN && errno != EOPNOTSUPP && errno != ENOSYS && errno != EINVAL) {
+        return -1;
+    }
+
+    ++numberOfNoWaitMisses_;
+    return function2();
 }
 
 
 void
-Async::waitForTask(Task *task)
+Async::runTasks(ThreadPoolTask *const *tasks, std::size_t numberOfTasks
+                , void (*function)(ThreadPoolTask *), ThreadPoolLane lane
+                , std::size_t numberOfTasksToWaitFor)
 {
     Event event = loop_->makeEvent();
+
+    for (std::size_t i = 0; i < numberOfTasks; ++i) {
+        auto task = static_cast<Task *>(tasks[i]);
+        task->event = &event;
+        task->numberOfTasksToWaitFor = &numberOfTasksToWaitFor;
+        task->isCompleted = false;
+    }
+
     ++taskCount_;
 
     auto scopeGuard = MakeScopeGuard([&] () -> void {
         --taskCount_;
     });
 
+    std::size_t numberOfAddedTasks = 0;
+    std::exception_ptr interruption;
+
     try {
-        (task->event = &event)->waitFor();
+        while (numberOfAddedTasks < numberOfTasks) {
+            queueEvent_->reset();
+            std::size_t n = threadPool_->tryAddTasks(tasks + numberOfAddedTasks
+                                                     , numberOfTasks - numberOfAddedTasks, function
+                                                     , lane);
+
+            if (n == 0) {
+                queueEvent_->waitFor();
+            } else {
+                numberOfAddedTasks += n;
+            }
+        }
+
+        event.waitFor();
+        return;
     } catch (FiberInterruption) {
-        bool taskIsCompleted;
-        threadPool_->removeTask(task, &taskIsCompleted);
+        interruption = std::current_exception();
+    }
 
-        if (!taskIsCompleted) {
-            throw;
+    if (cancelTasks(tasks, numberOfAddedTasks) && numberOfAddedTasks == numberOfTasks) {
+        loop_->interruptFiber(loop_->getCurrentFiber());
+        return;
+    }
+
+    for (std::size_t i = 0; i < numberOfTasks; ++i) {
+        if (static_cast<Task *>(tasks[i])->isCompleted) {
+            try {
+                tasks[i]->check();
+            } catch (...) {
+            }
         }
+    }
+
+    std::rethrow_exception(std::move(interruption));
+}
+
+
+bool
+Async::cancelTasks(ThreadPoolTask *const *tasks, std::size_t numberOfTasks)
+{
+    Event event = loop_->makeEvent();
+    std::size_t numberOfTasksToWaitFor = 0;
+    bool allTasksAreCompleted = true;
+
+    for (std::size_t i = 0; i < numberOfTasks; ++i) {
+        auto task = static_cast<Task *>(tasks[i]);
+
+        if (!task->isCompleted) {
+            allTasksAreCompleted = false;
+
+            if (!threadPool_->cancelTask(task)) {
+                task->event = &event;
+                task->numberOfTasksToWaitFor = &numberOfTasksToWaitFor;
+                ++numberOfTasksToWaitFor;
+            }
+        }
+    }
+
+    bool fiberIsInterrupted = false;
+
+    while (numberOfTasksToWaitFor >= 1) {
+        try {
+            event.waitFor();
+        } catch (FiberInterruption) {
+            fiberIsInterrupted = true;
+        }
+    }
 
+    if (fiberIsInterrupted) {
         loop_->interruptFiber(loop_->getCurrentFiber());
     }
+
+    return allTasksAreCompleted;
 }
 
+
+void
+Async::checkTasks(ThreadPoolTask *const *tasks, std::size_t numberOfTasks)
+{
+    std::exception_ptr exception;
+
+    for (std::size_t i = 0; i < numberOfTasks; ++i) {
+        try {
+            tasks[i]->check();
+        } catch (...) {
+            if (exception == nullptr) {
+                exception = std::current_exception();
+            }
+        }
+    }
+
+    if (exception != nullptr) {
+        std::rethrow_exception(std::move(exception));
+    }
+}
+
+
+namespace {
+
+void
+ExecuteBatchTask(ThreadPoolTask *threadPoolTask)
+{
+    (*static_cast<detail::AsyncBatchTask *>(threadPoolTask)->procedure)();
+}
+
+} // namespace
+
 } // namespace siren
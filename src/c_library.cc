@@ -3,6 +3,8 @@
 
 #include <fcntl.h>
 #include <netdb.h>
+#include <signal.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/uio.h>
 #include <unistd.h>
@@ -86,7 +88,7 @@ ssize_t
 siren_fs_read(int arg1, void *arg2, size_t arg3) noexcept
 {
     try {
-        return siren_async->callFunction(read, arg1, arg2, arg3);
+        return siren_async->read(arg1, arg2, arg3);
     } catch (siren::FiberInterruption) {
         errno = ECANCELED;
         return -1;
@@ -110,7 +112,7 @@ ssize_t
 siren_fs_write(int arg1, const void *arg2, size_t arg3) noexcept
 {
     try {
-        return siren_async->callFunction(write, arg1, arg2, arg3);
+        return siren_async->write(arg1, arg2, arg3);
     } catch (siren::FiberInterruption) {
         errno = ECANCELED;
         return -1;
@@ -134,7 +136,7 @@ ssize_t
 siren_fs_readv(int arg1, const struct iovec *arg2, int arg3) noexcept
 {
     try {
-        return siren_async->callFunction(readv, arg1, arg2, arg3);
+        return siren_async->readv(arg1, arg2, arg3);
     } catch (siren::FiberInterruption) {
         errno = ECANCELED;
         return -1;
@@ -158,7 +160,91 @@ ssize_t
 siren_fs_writev(int arg1, const struct iovec *arg2, int arg3) noexcept
 {
     try {
-        return siren_async->callFunction(writev, arg1, arg2, arg3);
+        return siren_async->writev(arg1, arg2, arg3);
+    } catch (siren::FiberInterruption) {
+        errno = ECANCELED;
+        return -1;
+    }
+}
+
+
+ssize_t
+siren_fs_pread(int arg1, void *arg2, size_t arg3, off_t arg4) noexcept
+{
+    try {
+        return siren_async->pread(arg1, arg2, arg3, arg4);
+    } catch (siren::FiberInterruption) {
+        errno = ECANCELED;
+        return -1;
+    }
+}
+
+
+ssize_t
+siren_fs_pwrite(int arg1, const void *arg2, size_t arg3, off_t arg4) noexcept
+{
+    try {
+        return siren_async->pwrite(arg1, arg2, arg3, arg4);
+    } catch (siren::FiberInterruption) {
+        errno = ECANCELED;
+        return -1;
+    }
+}
+
+
+ssize_t
+siren_fs_preadv(int arg1, const struct iovec *arg2, int arg3, off_t arg4) noexcept
+{
+    try {
+        return siren_async->preadv(arg1, arg2, arg3, arg4);
+    } catch (siren::FiberInterruption) {
+        errno = ECANCELED;
+        return -1;
+    }
+}
+
+
+ssize_t
+siren_fs_pwritev(int arg1, const struct iovec *arg2, int arg3, off_t arg4) noexcept
+{
+    try {
+        return siren_async->pwritev(arg1, arg2, arg3, arg4);
+    } catch (siren::FiberInterruption) {
+        errno = ECANCELED;
+        return -1;
+    }
+}
+
+
+int
+siren_fs_fsync(int arg1) noexcept
+{
+    try {
+        return siren_async->fsync(arg1);
+    } catch (siren::FiberInterruption) {
+        errno = ECANCELED;
+        return -1;
+    }
+}
+
+
+int
+siren_fs_fdatasync(int arg1) noexcept
+{
+    try {
+        return siren_async->fdatasync(arg1);
+    } catch (siren::FiberInterruption) {
+        errno = ECANCELED;
+        return -1;
+    }
+}
+
+
+int
+siren_fs_fallocate(int arg1, int arg2, off_t arg3, off_t arg4) noexcept
+{
+    try {
+        return siren_async->fallocate(arg1, arg2, arg3, arg4);
     } catch (siren::FiberInterruption) {
         errno = ECANCELED;
         return -1;
@@ -316,6 +402,68 @@ siren_sendto(int arg1, const void *arg2, size_t arg3, int arg4, const struct soc
 }
 
 
+int
+siren_recvmmsg(int arg1, struct mmsghdr *arg2, unsigned int arg3, int arg4, struct timespec *arg5)
+    noexcept
+{
+    try {
+        return siren_loop->recvmmsg(arg1, arg2, arg3, arg4, arg5);
+    } catch (siren::FiberInterruption) {
+        errno = ECANCELED;
+        return -1;
+    }
+}
+
+
+int
+siren_sendmmsg(int arg1, struct mmsghdr *arg2, unsigned int arg3, int arg4) noexcept
+{
+    try {
+        return siren_loop->sendmmsg(arg1, arg2, arg3, arg4);
+    } catch (siren::FiberInterruption) {
+        errno = ECANCELED;
+        return -1;
+    }
+}
+
+
+ssize_t
+siren_sendfile(int arg1, int arg2, off_t *arg3, size_t arg4) noexcept
+{
+    try {
+        return siren_loop->sendfile(arg1, arg2, arg3, arg4);
+    } catch (siren::FiberInterruption) {
+        errno = ECANCELED;
+        return -1;
+    }
+}
+
+
+ssize_t
+siren_splice(int arg1, loff_t *arg2, int arg3, loff_t *arg4, size_t arg5, unsigned int arg6)
+    noexcept
+{
+    try {
+        return siren_loop->splice(arg1, arg2, arg3, arg4, arg5, arg6);
+    } catch (siren::FiberInterruption) {
+        errno = ECANCELED;
+        return -1;
+    }
+}
+
+
+ssize_t
+siren_tee(int arg1, int arg2, size_t arg3, unsigned int arg4) noexcept
+{
+    try {
+        return siren_loop->tee(arg1, arg2, arg3, arg4);
+    } catch (siren::FiberInterruption) {
+        errno = ECANCELED;
+        return -1;
+    }
+}
+
+
 int
 siren_getaddrinfo(const char *arg1, const char *arg2, const struct addrinfo *arg3
                   , struct addrinfo **arg4) noexcept
@@ -354,6 +502,43 @@ siren_poll(struct pollfd *arg1, nfds_t arg2, int arg3) noexcept
 }
 
 
+int
+siren_ppoll(struct pollfd *arg1, nfds_t arg2, const struct timespec *arg3
+            , const sigset_t *arg4) noexcept
+{
+    try {
+        return siren_loop->ppoll(arg1, arg2, arg3, arg4);
+    } catch (siren::FiberInterruption) {
+        errno = ECANCELED;
+        return -1;
+    }
+}
+
+
+int
+siren_select(int arg1, fd_set *arg2, fd_set *arg3, fd_set *arg4, struct timeval *arg5) noexcept
+{
+    try {
+        return siren_loop->select(arg1, arg2, arg3, arg4, arg5);
+    } catch (siren::FiberInterruption) {
+        errno = ECANCELED;
+        return -1;
+    }
+}
+
+
+int
+siren_sigwaitinfo(const sigset_t *arg1, siginfo_t *arg2) noexcept
+{
+    try {
+        return siren_loop->waitForSignal(arg1, arg2);
+    } catch (siren::FiberInterruption) {
+        errno = ECANCELED;
+        return -1;
+    }
+}
+
+
 ssize_t
 maybe_siren_read(int arg1, void *arg2, size_t arg3) noexcept
 {
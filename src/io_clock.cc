@@ -4,6 +4,7 @@
 
 #include "assert.h"
 #include "config.h"
+#include "utility.h"
 
 
 namespace siren {
@@ -37,7 +38,8 @@ IOClock::operator=(IOClock &&other) noexcept
 void
 IOClock::initialize() noexcept
 {
-    now_ = std::chrono::milliseconds(0);
+    now_ = std::chrono::nanoseconds(0);
+    savedWakeupCount_ = 0;
 #ifdef SIREN_WITH_DEBUG
     startTime_ = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(-1));
 #endif
@@ -49,6 +51,7 @@ IOClock::move(IOClock *other) noexcept
 {
     other->now_ = now_;
     other->startTime_ = startTime_;
+    other->savedWakeupCount_ = savedWakeupCount_;
     initialize();
 }
 
@@ -74,7 +77,7 @@ IOClock::stop() noexcept
 {
     SIREN_ASSERT(startTime_.time_since_epoch().count() >= 0);
     std::chrono::steady_clock::time_point stopTime = std::chrono::steady_clock::now();
-    now_ += std::chrono::duration_cast<std::chrono::milliseconds>(stopTime - startTime_);
+    now_ += std::chrono::duration_cast<std::chrono::nanoseconds>(stopTime - startTime_);
 #ifdef SIREN_WITH_DEBUG
     startTime_ = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(-1));
 #endif
@@ -86,20 +89,31 @@ IOClock::restart() noexcept
 {
     SIREN_ASSERT(startTime_.time_since_epoch().count() >= 0);
     std::chrono::steady_clock::time_point stopTime = std::chrono::steady_clock::now();
-    now_ += std::chrono::duration_cast<std::chrono::milliseconds>(stopTime - startTime_);
+    now_ += std::chrono::duration_cast<std::chrono::nanoseconds>(stopTime - startTime_);
     startTime_ = stopTime;
 }
 
 
 void
-IOClock::addTimer(Timer *timer, std::chrono::milliseconds interval)
+IOClock::addTimer(Timer *timer, std::chrono::nanoseconds interval, std::chrono::nanoseconds slack)
 {
     SIREN_ASSERT(timer != nullptr);
 
-    if (interval.count() < 0) {
-        timer->expiryTime_ = std::chrono::milliseconds::max();
+    if (interval.count() < 0 || interval > std::chrono::nanoseconds::max() - now_) {
+        timer->expiryTime_ = std::chrono::nanoseconds::max();
+        timer->deadline_ = std::chrono::nanoseconds::max();
     } else {
         timer->expiryTime_ = now_ + interval;
+
+        if (slack.count() <= 0) {
+            timer->deadline_ = timer->expiryTime_;
+        } else if (slack > std::chrono::nanoseconds::max() - timer->expiryTime_) {
+            timer->deadline_ = std::chrono::nanoseconds::max();
+        } else {
+            auto granularity = NextPowerOfTwo(static_cast<std::uint64_t>(slack.count()) + 1) / 2;
+            timer->deadline_ = timer->expiryTime_ + slack;
+            timer->deadline_ -= timer->deadline_ % std::chrono::nanoseconds(granularity);
+        }
     }
 
     timerHeap_.insertNode(timer);
@@ -119,7 +133,7 @@ IOTimer::OrderHeapNode(const HeapNode *HeapNode1, const HeapNode *HeapNode2) noe
 {
     auto timer1 = static_cast<const IOTimer *>(HeapNode1);
     auto timer2 = static_cast<const IOTimer *>(HeapNode2);
-    return timer1->expiryTime_ <= timer2->expiryTime_;
+    return timer1->deadline_ <= timer2->deadline_;
 }
 
 } // namespace siren
@@ -2,6 +2,7 @@
 
 #include <cerrno>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <algorithm>
 #include <functional>
@@ -9,6 +10,8 @@
 #include <system_error>
 #include <utility>
 
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 
 #include "io_clock.h"
@@ -17,6 +20,13 @@
 
 namespace siren {
 
+namespace {
+
+timespec DurationToTime(std::chrono::nanoseconds);
+
+} // namespace
+
+
 IOPoller::IOPoller(std::size_t contextTagAlignment, std::size_t contextTagSize)
   : contextPool_(64, contextTagAlignment, contextTagSize)
 {
@@ -65,6 +75,42 @@ IOPoller::initialize()
     if (epollFD_ < 0) {
         throw std::system_error(errno, std::system_category(), "epoll_create1() failed");
     }
+
+    timerFD_ = -1;
+    timerFDIsArmed_ = false;
+    busyPollBudget_ = std::chrono::nanoseconds(0);
+    currentBusyPollBudget_ = std::chrono::nanoseconds(0);
+    spinningTime_ = std::chrono::nanoseconds(0);
+    sleepingTime_ = std::chrono::nanoseconds(0);
+
+    auto scopeGuard = MakeScopeGuard([&] () -> void {
+        finalize();
+    });
+
+#ifdef SYS_epoll_pwait2
+    timespec time = {0, 0};
+
+    if (syscall(SYS_epoll_pwait2, epollFD_, static_cast<epoll_event *>(events_), 1, &time
+                , nullptr, 0) < 0 && errno == ENOSYS)
+#endif
+    {
+        timerFD_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+        if (timerFD_ < 0) {
+            throw std::system_error(errno, std::system_category(), "timerfd_create() failed");
+        }
+
+        epoll_event event;
+        event.events = EPOLLIN | EPOLLET;
+        event.data.ptr = nullptr;
+
+        if (epoll_ctl(epollFD_, EPOLL_CTL_ADD, timerFD_, &event) < 0) {
+            throw std::system_error(errno, std::system_category()
+                                    , "epoll_ctl(EPOLL_CTL_ADD) failed");
+        }
+    }
+
+    scopeGuard.dismiss();
 }
 
 
@@ -77,6 +123,13 @@ IOPoller::finalize() noexcept
             std::terminate();
         }
 
+        if (timerFD_ >= 0) {
+            if (close(timerFD_) < 0 && errno != EINTR) {
+                std::perror("close() failed");
+                std::terminate();
+            }
+        }
+
         contextHashTable_.traverse([&] (HashTableNode *hashTableNode) -> void {
             auto context = static_cast<Context *>(hashTableNode);
             contextPool_.destroyObject(context);
@@ -89,6 +142,12 @@ void
 IOPoller::move(IOPoller *other) noexcept
 {
     other->epollFD_ = epollFD_;
+    other->timerFD_ = timerFD_;
+    other->timerFDIsArmed_ = timerFDIsArmed_;
+    other->busyPollBudget_ = busyPollBudget_;
+    other->currentBusyPollBudget_ = currentBusyPollBudget_;
+    other->spinningTime_ = spinningTime_;
+    other->sleepingTime_ = sleepingTime_;
     epollFD_ = -1;
 }
 
@@ -162,6 +221,15 @@ IOPoller::destroyContext(int fd) noexcept
 }
 
 
+void
+IOPoller::setBusyPollBudget(std::chrono::nanoseconds busyPollBudget) noexcept
+{
+    SIREN_ASSERT(busyPollBudget.count() >= 0);
+    busyPollBudget_ = busyPollBudget;
+    currentBusyPollBudget_ = busyPollBudget;
+}
+
+
 const void *
 IOPoller::getContextTag(int fd) const noexcept
 {
@@ -237,7 +305,7 @@ IOPoller::addWatcher(Watcher *watcher, int fd, Condition conditions) noexcept
     bool contextIsModified = false;
 
     for (Condition condition : {SIREN__IO_CONDITIONS}) {
-        if ((conditions & condition) == condition) {
+        if ((watcher->conditions_ & condition) == condition) {
             if (++*watcherCount == 1) {
                 context->pendingConditions |= condition;
                 contextIsModified = true;
@@ -341,12 +409,42 @@ IOPoller::pollEvents(Clock *clock)
 {
     std::size_t eventCount = 0;
     clock->start();
-    int timeout = std::min(clock->getDueTime()
-                           , std::chrono::milliseconds(std::numeric_limits<int>::max())).count();
+    std::chrono::nanoseconds timeout = clock->getDueTime();
+
+    if (timeout.count() != 0 && currentBusyPollBudget_.count() >= 1) {
+        int numberOfEvents = spinForEvents(timeout);
+
+        if (numberOfEvents < 0) {
+            clock->stop();
+            throw std::system_error(errno, std::system_category(), "epoll_wait() failed");
+        }
+
+        if (numberOfEvents == 0) {
+            clock->restart();
+            timeout = clock->getDueTime();
+        } else {
+            eventCount = numberOfEvents;
+
+            if (eventCount < events_.getLength()) {
+                clock->stop();
+                return eventCount;
+            } else {
+                events_.setLength(eventCount + 1);
+                timeout = std::chrono::nanoseconds(0);
+            }
+        }
+    }
 
     for (;;) {
-        int numberOfEvents = epoll_wait(epollFD_, events_ + eventCount
-                                        , events_.getLength() - eventCount, timeout);
+        int numberOfEvents;
+
+        if (timeout.count() == 0) {
+            numberOfEvents = waitForEvents(eventCount, timeout);
+        } else {
+            std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            numberOfEvents = waitForEvents(eventCount, timeout);
+            sleepingTime_ += std::chrono::steady_clock::now() - startTime;
+        }
 
         if (numberOfEvents < 0) {
             if (errno != EINTR) {
@@ -355,9 +453,7 @@ IOPoller::pollEvents(Clock *clock)
             }
 
             clock->restart();
-            timeout = std::min(clock->getDueTime()
-                               , std::chrono::milliseconds(std::numeric_limits<int>::max()))
-                      .count();
+            timeout = clock->getDueTime();
         } else {
             clock->stop();
             eventCount += numberOfEvents;
@@ -367,7 +463,7 @@ IOPoller::pollEvents(Clock *clock)
             } else {
                 events_.setLength(eventCount + 1);
                 clock->start();
-                timeout = 0;
+                timeout = std::chrono::nanoseconds(0);
             }
         }
     }
@@ -375,4 +471,115 @@ IOPoller::pollEvents(Clock *clock)
     return eventCount;
 }
 
+
+int
+IOPoller::spinForEvents(std::chrono::nanoseconds timeout)
+{
+    std::chrono::nanoseconds budget = currentBusyPollBudget_;
+
+    if (timeout.count() >= 0 && timeout < budget) {
+        budget = timeout;
+    }
+
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point now;
+    int numberOfEvents;
+
+    do {
+        numberOfEvents = waitForEvents(0, std::chrono::nanoseconds(0));
+        now = std::chrono::steady_clock::now();
+    } while ((numberOfEvents == 0 || (numberOfEvents < 0 && errno == EINTR))
+             && now - startTime < budget);
+
+    spinningTime_ += now - startTime;
+
+    if (numberOfEvents >= 1) {
+        currentBusyPollBudget_ = std::min(2 * currentBusyPollBudget_, busyPollBudget_);
+    } else if (budget == currentBusyPollBudget_) {
+        currentBusyPollBudget_ = std::max(currentBusyPollBudget_ / 2, busyPollBudget_ / 16);
+    }
+
+    return numberOfEvents < 0 && errno == EINTR ? 0 : numberOfEvents;
+}
+
+
+int
+IOPoller::waitForEvents(std::size_t eventOffset, std::chrono::nanoseconds timeout)
+{
+    epoll_event *events = events_ + eventOffset;
+    int maxNumberOfEvents = events_.getLength() - eventOffset;
+    int numberOfEvents;
+
+    if (timeout.count() < 0 || timeout % std::chrono::milliseconds(1)
+                               == std::chrono::nanoseconds(0)) {
+        int timeout2 = timeout.count() < 0
+                       ? -1
+                       : std::min(std::chrono::duration_cast<std::chrono::milliseconds>(timeout)
+                                  , std::chrono::milliseconds(std::numeric_limits<int>::max()))
+                         .count();
+
+        if (timerFDIsArmed_) {
+            armTimerFD(std::chrono::nanoseconds(0));
+        }
+
+        numberOfEvents = epoll_wait(epollFD_, events, maxNumberOfEvents, timeout2);
+#ifdef SYS_epoll_pwait2
+    } else if (timerFD_ < 0) {
+        timespec time = DurationToTime(timeout);
+        return syscall(SYS_epoll_pwait2, epollFD_, events, maxNumberOfEvents, &time, nullptr, 0);
+#endif
+    } else {
+        armTimerFD(timeout);
+        numberOfEvents = epoll_wait(epollFD_, events, maxNumberOfEvents, -1);
+    }
+
+    if (timerFD_ >= 0) {
+        for (int i = 0; i < numberOfEvents; ++i) {
+            if (events[i].data.ptr == nullptr) {
+                std::uint64_t dummy;
+
+                if (read(timerFD_, &dummy, sizeof(dummy)) < 0 && errno != EAGAIN) {
+                    std::perror("read() failed");
+                    std::terminate();
+                }
+
+                timerFDIsArmed_ = false;
+                events[i--] = events[--numberOfEvents];
+            }
+        }
+    }
+
+    return numberOfEvents;
+}
+
+
+void
+IOPoller::armTimerFD(std::chrono::nanoseconds timeout) noexcept
+{
+    itimerspec value;
+    value.it_interval = {0, 0};
+    value.it_value = DurationToTime(timeout);
+
+    if (timerfd_settime(timerFD_, 0, &value, nullptr) < 0) {
+        std::perror("timerfd_settime() failed");
+        std::terminate();
+    }
+
+    timerFDIsArmed_ = timeout.count() >= 1;
+}
+
+
+namespace {
+
+timespec
+DurationToTime(std::chrono::nanoseconds duration)
+{
+    timespec time;
+    time.tv_sec = std::chrono::duration_cast<std::chrono::seconds>(duration).count();
+    time.tv_nsec = (duration % std::chrono::seconds(1)).count();
+    return time;
+}
+
+} // namespace
+
 } // namespace siren
@@ -1,15 +1,24 @@
 #include "loop.h"
 
 #include <cerrno>
+#include <cstdint>
 #include <cstdio>
+#include <chrono>
 #include <functional>
+#include <memory>
 #include <system_error>
 #include <utility>
+#include <vector>
 
 #include <fcntl.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
 #include <sys/stat.h>
 
 #include "config.h"
+#include "stream.h"
 #include "utility.h"
 #include "scope_guard.h"
 
@@ -37,6 +46,10 @@ struct FileOptions
     bool blocking: 1;
     long readTimeout;
     long writeTimeout;
+    WriteBuffer *writeBuffer;
+    std::size_t zeroCopyThreshold;
+    std::uint32_t zeroCopySequenceNumber;
+    std::uint32_t completedZeroCopySequenceNumber;
 };
 
 } // namespace detail
@@ -63,13 +76,40 @@ struct MyIOTimer
 bool SetBlocking(int, bool);
 long TimeToTimeout(timeval);
 timeval TimeoutToTime(long);
+std::chrono::nanoseconds TimeToDuration(timespec);
+IOCondition PollEventsToIOConditions(short);
+short IOConditionsToPollEvents(IOCondition);
+bool FileIsReadable(int) noexcept;
 
 } // namespace
 
 
+namespace detail {
+
+struct WriteBuffer
+  : ListNode
+{
+    int fd;
+    bool isSocket;
+    bool isDirty;
+    bool isWaiting;
+    bool isTimed;
+    int errorNumber;
+    std::size_t maxDataSize;
+    Stream data;
+    MyIOWatcher myIOWatcher;
+    MyIOTimer myIOTimer;
+};
+
+} // namespace detail
+
+
 Loop::Loop(std::size_t defaultFiberSize)
   : ioPoller_(alignof(FileOptions), sizeof(FileOptions)),
-    scheduler_(defaultFiberSize)
+    scheduler_(defaultFiberSize),
+    timerSlack_(0),
+    hasCPUAffinity_(false),
+    numberOfWaitingWriteBuffers_(0)
 {
 }
 
@@ -77,10 +117,15 @@ Loop::Loop(std::size_t defaultFiberSize)
 void
 Loop::run()
 {
+    if (hasCPUAffinity_ && sched_setaffinity(0, sizeof(cpuAffinity_), &cpuAffinity_) < 0) {
+        throw std::system_error(errno, std::system_category(), "sched_setaffinity() failed");
+    }
+
     for (;;) {
         scheduler_.run();
+        flushWriteBuffers();
 
-        if (scheduler_.getNumberOfForegroundFibers() == 0) {
+        if (scheduler_.getNumberOfForegroundFibers() == 0 && numberOfWaitingWriteBuffers_ == 0) {
             return;
         } else {
             ioPoller_.getReadyWatchers(&ioClock_, [] (IOWatcher *ioWatcher
@@ -154,9 +199,10 @@ Loop::manageFD(int fd)
 }
 
 
-void
+int
 Loop::unmanageFD(int fd) noexcept
 {
+    int errorNumber = finishWrites(fd, 1000000);
     FileOptions *fileOptions = getFileOptions(fd);
 
     if (fileOptions->blocking) {
@@ -185,6 +231,13 @@ Loop::unmanageFD(int fd) noexcept
     }
 
     destroyIOContext(fd);
+
+    if (errorNumber != 0) {
+        errno = errorNumber;
+        return -1;
+    }
+
+    return 0;
 }
 
 
@@ -290,7 +343,19 @@ ssize_t
 Loop::write(int fd, const void *data, size_t dataSize)
 {
     LOOP_CHECK_FD(fd);
-    return writeFile(fd, getEffectiveWriteTimeout(fd), ::write, data, dataSize);
+    long timeout = getEffectiveWriteTimeout(fd);
+    WriteBuffer *writeBuffer = getFileOptions(fd)->writeBuffer;
+
+    if (writeBuffer != nullptr) {
+        iovec vector = {const_cast<void *>(data), dataSize};
+        ssize_t numberOfBytes = bufferFile(writeBuffer, timeout, &vector, 1);
+
+        if (numberOfBytes != 0) {
+            return numberOfBytes;
+        }
+    }
+
+    return writeFile(fd, timeout, ::write, data, dataSize);
 }
 
 
@@ -306,7 +371,18 @@ ssize_t
 Loop::writev(int fd, const iovec *vector, int vectorLength)
 {
     LOOP_CHECK_FD(fd);
-    return writeFile(fd, getEffectiveWriteTimeout(fd), ::writev, vector, vectorLength);
+    long timeout = getEffectiveWriteTimeout(fd);
+    WriteBuffer *writeBuffer = getFileOptions(fd)->writeBuffer;
+
+    if (writeBuffer != nullptr) {
+        ssize_t numberOfBytes = bufferFile(writeBuffer, timeout, vector, vectorLength);
+
+        if (numberOfBytes != 0) {
+            return numberOfBytes;
+        }
+    }
+
+    return writeFile(fd, timeout, ::writev, vector, vectorLength);
 }
 
 
@@ -420,7 +496,7 @@ Loop::accept4(int fd, sockaddr *name, socklen_t *nameSize, int flags)
         if (subFD < 0) {
             if (errno == EAGAIN) {
                 if (!waitForFile(fd, IOCondition::In, nullptr
-                                 , std::chrono::milliseconds(getEffectiveReadTimeout(fd)))) {
+                                 , std::chrono::microseconds(getEffectiveReadTimeout(fd)))) {
                     errno = EAGAIN;
                     return -1;
                 }
@@ -448,6 +524,72 @@ Loop::accept4(int fd, sockaddr *name, socklen_t *nameSize, int flags)
 }
 
 
+int
+Loop::acceptMany(int fd, int *subFDs, sockaddr_storage *names, int maxNumberOfSubFDs, int flags)
+{
+    LOOP_CHECK_FD(fd);
+    int numberOfSubFDs = 0;
+
+    auto scopeGuard1 = MakeScopeGuard([&] () -> void {
+        for (int i = 0; i < numberOfSubFDs; ++i) {
+            close(subFDs[i]);
+        }
+    });
+
+    while (numberOfSubFDs < maxNumberOfSubFDs) {
+        sockaddr *name;
+        socklen_t nameSize = sizeof(*names);
+        socklen_t *nameSizePointer;
+
+        if (names == nullptr) {
+            name = nullptr;
+            nameSizePointer = nullptr;
+        } else {
+            name = reinterpret_cast<sockaddr *>(&names[numberOfSubFDs]);
+            nameSizePointer = &nameSize;
+        }
+
+        int subFD;
+
+        if (numberOfSubFDs == 0) {
+            subFD = accept4(fd, name, nameSizePointer, flags);
+
+            if (subFD < 0) {
+                return -1;
+            }
+        } else {
+            subFD = ::accept4(fd, name, nameSizePointer, flags | SOCK_NONBLOCK);
+
+            if (subFD < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                } else {
+                    break;
+                }
+            }
+
+            auto scopeGuard2 = MakeScopeGuard([&] () -> void {
+                if (::close(subFD) < 0 && errno != EINTR) {
+                    std::perror("close() failed");
+                    std::terminate();
+                }
+            });
+
+            bool blocking = (flags & SOCK_NONBLOCK) == 0;
+            FileOptions *fileOptions = getFileOptions(fd);
+            createIOContext(subFD, true, blocking, fileOptions->readTimeout
+                            , fileOptions->writeTimeout);
+            scopeGuard2.dismiss();
+        }
+
+        subFDs[numberOfSubFDs++] = subFD;
+    }
+
+    scopeGuard1.dismiss();
+    return numberOfSubFDs;
+}
+
+
 int
 Loop::connect(int fd, const sockaddr *name, socklen_t nameSize)
 {
@@ -456,7 +598,7 @@ Loop::connect(int fd, const sockaddr *name, socklen_t nameSize)
     if (::connect(fd, name, nameSize) < 0) {
         if (errno == EINTR || errno == EINPROGRESS) {
             if (waitForFile(fd, IOCondition::Out, nullptr
-                            , std::chrono::milliseconds(getEffectiveWriteTimeout(fd)))) {
+                            , std::chrono::microseconds(getEffectiveWriteTimeout(fd)))) {
                 int errorNumber;
                 socklen_t errorNumberSize = sizeof(errorNumber);
 
@@ -537,6 +679,29 @@ Loop::send(int fd, const void *data, size_t dataSize, int flags)
         timeout = getEffectiveWriteTimeout(fd);
     }
 
+    FileOptions *fileOptions = getFileOptions(fd);
+    WriteBuffer *writeBuffer = fileOptions->writeBuffer;
+
+    if (writeBuffer != nullptr) {
+        if ((flags & ~MSG_NOSIGNAL) == 0) {
+            iovec vector = {const_cast<void *>(data), dataSize};
+            ssize_t numberOfBytes = bufferFile(writeBuffer, timeout, &vector, 1);
+
+            if (numberOfBytes != 0) {
+                return numberOfBytes;
+            }
+        } else {
+            if (flushWriteBuffer(writeBuffer, timeout) < 0) {
+                return -1;
+            }
+        }
+    }
+
+    if (fileOptions->zeroCopyThreshold >= 1 && dataSize >= fileOptions->zeroCopyThreshold
+        && timeout != 0) {
+        return sendZeroCopy(fd, timeout, data, dataSize, flags);
+    }
+
     return writeFile(fd, timeout, ::send, data, dataSize, flags);
 }
 
@@ -596,218 +761,690 @@ Loop::sendto(int fd, const void *data, size_t dataSize, int flags, const sockadd
         timeout = getEffectiveWriteTimeout(fd);
     }
 
+    WriteBuffer *writeBuffer = getFileOptions(fd)->writeBuffer;
+
+    if (writeBuffer != nullptr && flushWriteBuffer(writeBuffer, timeout) < 0) {
+        return -1;
+    }
+
     return writeFile(fd, timeout, ::sendto, data, dataSize, flags, name, nameSize);
 }
 
 
 int
-Loop::close(int fd) noexcept
+Loop::recvmmsg(int fd, mmsghdr *vector, unsigned int vectorLength, int flags, timespec *timeout)
 {
     LOOP_CHECK_FD(fd);
-    destroyIOContext(fd);
-    return ::close(fd);
+    long timeout2;
+
+    if ((flags & MSG_DONTWAIT) == MSG_DONTWAIT) {
+        flags &= ~MSG_DONTWAIT;
+        timeout2 = 0;
+    } else {
+        timeout2 = getEffectiveReadTimeout(fd);
+    }
+
+    return readFile(fd, timeout2, ::recvmmsg, vector, vectorLength, flags, timeout);
 }
 
 
 int
-Loop::poll(pollfd *pollFDs, nfds_t numberOfPollFDs, int timeout)
+Loop::sendmmsg(int fd, mmsghdr *vector, unsigned int vectorLength, int flags)
 {
-    if (numberOfPollFDs == 0) {
-        setDelay(std::chrono::milliseconds(timeout));
-        return 0;
-    } else if (numberOfPollFDs == 1) {
-        if (pollFDs == nullptr) {
-            errno = EFAULT;
-            return -1;
-        } else {
-            pollfd *pollFD = &pollFDs[0];
-
-            if (fdIsManaged(pollFD->fd)) {
-                IOCondition ioConditions = IOCondition::No;
-
-                for (std::pair<int, IOCondition> x : {
-                     std::make_pair(POLLIN, IOCondition::In),
-                     std::make_pair(POLLOUT, IOCondition::Out),
-                     std::make_pair(POLLRDHUP, IOCondition::RdHup),
-                     std::make_pair(POLLPRI, IOCondition::Pri),
-                }) {
-                    if ((pollFD->events & x.first) == x.first) {
-                        ioConditions |= x.second;
-                    }
-                }
-
-                IOCondition readyIOConditions;
+    LOOP_CHECK_FD(fd);
+    long timeout;
 
-                if (waitForFile(pollFD->fd, ioConditions, &readyIOConditions
-                                , std::chrono::milliseconds(timeout))) {
-                    pollFD->revents = 0;
+    if ((flags & MSG_DONTWAIT) == MSG_DONTWAIT) {
+        flags &= ~MSG_DONTWAIT;
+        timeout = 0;
+    } else {
+        timeout = getEffectiveWriteTimeout(fd);
+    }
 
-                    for (std::pair<IOCondition, int> x : {
-                         std::make_pair(IOCondition::In, POLLIN),
-                         std::make_pair(IOCondition::Out, POLLOUT),
-                         std::make_pair(IOCondition::RdHup, POLLRDHUP),
-                         std::make_pair(IOCondition::Pri, POLLPRI),
-                         std::make_pair(IOCondition::Err, POLLERR),
-                         std::make_pair(IOCondition::Hup, POLLHUP),
-                    }) {
-                        if ((readyIOConditions & x.first) == x.first) {
-                            pollFD->revents |= x.second;
-                        }
-                    }
+    WriteBuffer *writeBuffer = getFileOptions(fd)->writeBuffer;
 
-                    return 1;
-                } else {
-                    return 0;
-                }
-            } else {
-#ifdef SIREN_WITH_DEBUG
-                SIREN_ASSERT(false);
-#else
-                pollFD->revents = POLLNVAL;
-                return 1;
-#endif
-            }
-        }
-    } else {
-        errno = ENOSYS;
+    if (writeBuffer != nullptr && flushWriteBuffer(writeBuffer, timeout) < 0) {
         return -1;
     }
-}
 
+    return writeFile(fd, timeout, ::sendmmsg, vector, vectorLength, flags);
+}
 
 
-template <class T, class ...U>
 ssize_t
-Loop::readFile(int fd, long timeout, T &&function, U &&...argument)
+Loop::sendfile(int outFD, int inFD, off_t *offset, size_t count)
 {
-    for (;;) {
-        ssize_t numberOfBytes = function(fd, std::forward<U>(argument)...);
+    LOOP_CHECK_FD(outFD);
+    WriteBuffer *writeBuffer = getFileOptions(outFD)->writeBuffer;
 
-        if (numberOfBytes < 0) {
-            if (errno == EAGAIN) {
-                if (!waitForFile(fd, IOCondition::In, nullptr
-                                 , std::chrono::milliseconds(timeout))) {
-                    errno = EAGAIN;
-                    return -1;
-                }
-            } else {
-                if (errno != EINTR) {
-                    return -1;
-                }
-            }
-        } else {
-            return numberOfBytes;
-        }
+    if (writeBuffer != nullptr
+        && flushWriteBuffer(writeBuffer, getEffectiveWriteTimeout(outFD)) < 0) {
+        return -1;
     }
+
+    return transferFile(-1, outFD, ::sendfile, outFD, inFD, offset, count);
 }
 
 
-template <class T, class ...U>
 ssize_t
-Loop::writeFile(int fd, long timeout, T &&function, U &&...argument)
+Loop::splice(int inFD, loff_t *inOffset, int outFD, loff_t *outOffset, size_t length
+             , unsigned int flags)
 {
-    for (;;) {
-        ssize_t numberOfBytes = function(fd, std::forward<U>(argument)...);
+    if (fdIsManaged(outFD)) {
+        WriteBuffer *writeBuffer = getFileOptions(outFD)->writeBuffer;
 
-        if (numberOfBytes < 0) {
-            if (errno == EAGAIN) {
-                if (!waitForFile(fd, IOCondition::Out, nullptr
-                                 , std::chrono::milliseconds(timeout))) {
-                    errno = EAGAIN;
-                    return -1;
-                }
-            } else {
-                if (errno != EINTR) {
-                    return -1;
-                }
-            }
-        } else {
-            return numberOfBytes;
+        if (writeBuffer != nullptr
+            && flushWriteBuffer(writeBuffer, getEffectiveWriteTimeout(outFD)) < 0) {
+            return -1;
         }
     }
+
+    return transferFile(inFD, outFD, ::splice, inFD, inOffset, outFD, outOffset, length
+                        , flags | SPLICE_F_NONBLOCK);
 }
 
 
-const detail::FileOptions *
-Loop::getFileOptions(int fd) const noexcept
+ssize_t
+Loop::tee(int inFD, int outFD, size_t length, unsigned int flags)
 {
-    return static_cast<const FileOptions *>(ioPoller_.getContextTag(fd));
+    return transferFile(inFD, outFD, ::tee, inFD, outFD, length, flags | SPLICE_F_NONBLOCK);
 }
 
 
-detail::FileOptions *
-Loop::getFileOptions(int fd) noexcept
+int
+Loop::close(int fd) noexcept
 {
-    return static_cast<FileOptions *>(ioPoller_.getContextTag(fd));
-}
+    LOOP_CHECK_FD(fd);
+    int errorNumber = finishWrites(fd, 1000000);
+    const FileOptions *fileOptions = getFileOptions(fd);
 
+    if (fileOptions->completedZeroCopySequenceNumber != fileOptions->zeroCopySequenceNumber) {
+        linger value = {1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &value, sizeof(value));
+    }
 
-void
-Loop::createIOContext(int fd, bool isSocket, bool blocking, long readTimeout, long writeTimeout)
-{
-    ioPoller_.createContext(fd);
-    FileOptions *fileOptions = getFileOptions(fd);
-    fileOptions->isSocket = isSocket;
-    fileOptions->blocking = blocking;
-    fileOptions->readTimeout = readTimeout;
-    fileOptions->writeTimeout = writeTimeout;
-}
+    destroyIOContext(fd);
 
+    if (::close(fd) < 0) {
+        return -1;
+    }
 
-void
-Loop::destroyIOContext(int fd) noexcept
-{
-    ioPoller_.destroyContext(fd);
+    if (errorNumber != 0) {
+        errno = errorNumber == EINTR ? EINTR : ECOMM;
+        return -1;
+    }
+
+    return 0;
 }
 
 
-long
-Loop::getEffectiveReadTimeout(int fd) const noexcept
+int
+Loop::waitForSignal(const sigset_t *signalSet, siginfo_t *signalInfo)
 {
-    const FileOptions *fileOptions = getFileOptions(fd);
-    return fileOptions->blocking ? fileOptions->readTimeout : 0;
-}
+    int fd = ::signalfd(-1, signalSet, SFD_NONBLOCK | SFD_CLOEXEC);
 
+    if (fd < 0) {
+        return -1;
+    }
 
-long
-Loop::getEffectiveWriteTimeout(int fd) const noexcept
-{
-    const FileOptions *fileOptions = getFileOptions(fd);
-    return fileOptions->blocking ? fileOptions->writeTimeout : 0;
+    auto scopeGuard1 = MakeScopeGuard([&] () -> void {
+        if (::close(fd) < 0 && errno != EINTR) {
+            std::perror("close() failed");
+            std::terminate();
+        }
+    });
+
+    createIOContext(fd, false, true);
+
+    auto scopeGuard2 = MakeScopeGuard([&] () -> void {
+        destroyIOContext(fd);
+    });
+
+    signalfd_siginfo signalFDInfo;
+
+    if (readFile(fd, -1, ::read, &signalFDInfo, sizeof(signalFDInfo)) < 0) {
+        return -1;
+    }
+
+    if (signalInfo != nullptr) {
+        *signalInfo = {};
+        signalInfo->si_signo = signalFDInfo.ssi_signo;
+        signalInfo->si_errno = signalFDInfo.ssi_errno;
+        signalInfo->si_code = signalFDInfo.ssi_code;
+        signalInfo->si_pid = signalFDInfo.ssi_pid;
+        signalInfo->si_uid = signalFDInfo.ssi_uid;
+        signalInfo->si_status = signalFDInfo.ssi_status;
+        signalInfo->si_value.sival_ptr = reinterpret_cast<void *>(signalFDInfo.ssi_ptr);
+    }
+
+    return signalFDInfo.ssi_signo;
 }
 
 
-bool
-Loop::waitForFile(int fd, IOCondition ioConditions, IOCondition *readyIOConditions
-                  , std::chrono::milliseconds timeout)
+int
+Loop::setWriteCoalescing(int fd, std::size_t maxDataSize)
 {
-    if (timeout.count() < 0) {
-        struct {
-            IOCondition *readyIOConditions;
-            void *fiberHandle;
-            Scheduler *scheduler;
-        } context;
+    LOOP_CHECK_FD(fd);
+    FileOptions *fileOptions = getFileOptions(fd);
+    WriteBuffer *writeBuffer = fileOptions->writeBuffer;
 
-        MyIOWatcher myIOWatcher;
+    if (maxDataSize == 0) {
+        if (writeBuffer != nullptr) {
+            if (flushWriteBuffer(writeBuffer, getEffectiveWriteTimeout(fd)) < 0) {
+                return -1;
+            }
 
-        myIOWatcher.callback = [&context] (IOCondition readyIOConditions) -> void {
-            if (context.readyIOConditions != nullptr) {
-                *context.readyIOConditions = readyIOConditions;
+            destroyWriteBuffer(writeBuffer);
+            fileOptions->writeBuffer = nullptr;
+        }
+    } else {
+        if (writeBuffer == nullptr) {
+            if (fileOptions->isSocket) {
+                int type;
+                socklen_t typeSize = sizeof(type);
+
+                if (::getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &typeSize) < 0) {
+                    return -1;
+                }
+
+                if (type != SOCK_STREAM) {
+                    errno = EINVAL;
+                    return -1;
+                }
             }
 
-            context.scheduler->resumeFiber(context.fiberHandle);
-        };
+            writeBuffer = new WriteBuffer;
+            writeBuffer->fd = fd;
+            writeBuffer->isSocket = fileOptions->isSocket;
+            writeBuffer->isDirty = false;
+            writeBuffer->isWaiting = false;
+            writeBuffer->isTimed = false;
+            writeBuffer->errorNumber = 0;
+
+            writeBuffer->myIOWatcher.callback = [this, writeBuffer] (IOCondition) -> void {
+                if (!writeBuffer->isDirty) {
+                    writeBuffer->isDirty = true;
+                    dirtyWriteBufferList_.appendNode(writeBuffer);
+                }
+            };
 
-        ioPoller_.addWatcher(&myIOWatcher, fd, ioConditions);
+            writeBuffer->myIOTimer.callback = [this, writeBuffer] () -> void {
+                writeBuffer->isTimed = false;
+                writeBuffer->data.reset();
+                writeBuffer->errorNumber = ETIMEDOUT;
+                stopWaitingForWriteBuffer(writeBuffer);
+            };
 
-        auto scopeGuard = MakeScopeGuard([&] () -> void {
-            ioPoller_.removeWatcher(&myIOWatcher);
-        });
+            fileOptions->writeBuffer = writeBuffer;
+        }
 
-        context.readyIOConditions = readyIOConditions;
-        (context.scheduler = &scheduler_)->suspendFiber(context.fiberHandle = scheduler_
-                                                                              .getCurrentFiber());
-        return true;
+        writeBuffer->maxDataSize = maxDataSize;
+    }
+
+    return 0;
+}
+
+
+int
+Loop::setZeroCopy(int fd, std::size_t threshold)
+{
+    LOOP_CHECK_FD(fd);
+    FileOptions *fileOptions = getFileOptions(fd);
+
+    if (threshold >= 1 && fileOptions->zeroCopyThreshold == 0) {
+        int onOff = 1;
+
+        if (::setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &onOff, sizeof(onOff)) < 0) {
+            return -1;
+        }
+    }
+
+    fileOptions->zeroCopyThreshold = threshold;
+    return 0;
+}
+
+
+int
+Loop::getZeroCopySequenceNumber(int fd, std::uint32_t *sequenceNumber) const noexcept
+{
+    LOOP_CHECK_FD(fd);
+    *sequenceNumber = getFileOptions(fd)->zeroCopySequenceNumber;
+    return 0;
+}
+
+
+int
+Loop::waitForZeroCopy(int fd, std::uint32_t sequenceNumber)
+{
+    LOOP_CHECK_FD(fd);
+    return waitForZeroCopyCompletions(fd, sequenceNumber, getEffectiveWriteTimeout(fd));
+}
+
+
+int
+Loop::flush(int fd)
+{
+    LOOP_CHECK_FD(fd);
+    WriteBuffer *writeBuffer = getFileOptions(fd)->writeBuffer;
+    long timeout = getEffectiveWriteTimeout(fd);
+
+    if (writeBuffer != nullptr && flushWriteBuffer(writeBuffer, timeout) < 0) {
+        return -1;
+    }
+
+    return waitForZeroCopyCompletions(fd, getFileOptions(fd)->zeroCopySequenceNumber, timeout);
+}
+
+
+int
+Loop::poll(pollfd *pollFDs, nfds_t numberOfPollFDs, int timeout)
+{
+    return pollFiles(pollFDs, numberOfPollFDs, std::chrono::milliseconds(timeout));
+}
+
+
+int
+Loop::ppoll(pollfd *pollFDs, nfds_t numberOfPollFDs, const timespec *timeout
+            , const sigset_t *signalMask)
+{
+    if (signalMask != nullptr) {
+        errno = ENOSYS;
+        return -1;
+    } else {
+        return pollFiles(pollFDs, numberOfPollFDs, timeout == nullptr
+                                                    ? std::chrono::nanoseconds(-1)
+                                                    : TimeToDuration(*timeout));
+    }
+}
+
+
+int
+Loop::select(int numberOfFDs, fd_set *readFDs, fd_set *writeFDs, fd_set *exceptFDs
+             , timeval *timeout)
+{
+    if (numberOfFDs < 0 || numberOfFDs > FD_SETSIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    std::vector<pollfd> pollFDs;
+
+    for (int fd = 0; fd < numberOfFDs; ++fd) {
+        short events = 0;
+
+        if (readFDs != nullptr && FD_ISSET(fd, readFDs)) {
+            events |= POLLIN;
+        }
+
+        if (writeFDs != nullptr && FD_ISSET(fd, writeFDs)) {
+            events |= POLLOUT;
+        }
+
+        if (exceptFDs != nullptr && FD_ISSET(fd, exceptFDs)) {
+            events |= POLLPRI;
+        }
+
+        if (events != 0) {
+            pollFDs.push_back({fd, events, 0});
+        }
+    }
+
+    if (pollFiles(pollFDs.data(), pollFDs.size(), timeout == nullptr
+                                                  ? std::chrono::nanoseconds(-1)
+                                                  : std::chrono::seconds(timeout->tv_sec)
+                                                    + std::chrono::microseconds(timeout->tv_usec))
+        < 0) {
+        return -1;
+    }
+
+    int readyFDCount = 0;
+
+    for (const pollfd &pollFD : pollFDs) {
+        if ((pollFD.revents & POLLNVAL) == POLLNVAL) {
+            errno = EBADF;
+            return -1;
+        }
+    }
+
+    for (const pollfd &pollFD : pollFDs) {
+        for (std::pair<fd_set *, short> x : {
+             std::make_pair(readFDs, short(POLLIN | POLLHUP | POLLERR)),
+             std::make_pair(writeFDs, short(POLLOUT | POLLERR)),
+             std::make_pair(exceptFDs, short(POLLPRI)),
+        }) {
+            if (x.first != nullptr && FD_ISSET(pollFD.fd, x.first)) {
+                if ((pollFD.revents & x.second) == 0) {
+                    FD_CLR(pollFD.fd, x.first);
+                } else {
+                    ++readyFDCount;
+                }
+            }
+        }
+    }
+
+    return readyFDCount;
+}
+
+
+int
+Loop::pollFiles(pollfd *pollFDs, nfds_t numberOfPollFDs, std::chrono::nanoseconds timeout)
+{
+    if (numberOfPollFDs == 0) {
+        setDelay(timeout, timerSlack_);
+        return 0;
+    }
+
+    if (pollFDs == nullptr) {
+        errno = EFAULT;
+        return -1;
+    }
+
+    bool someFDsAreUnmanaged = false;
+
+    for (nfds_t i = 0; i < numberOfPollFDs; ++i) {
+        pollfd *pollFD = &pollFDs[i];
+        pollFD->revents = 0;
+
+        if (pollFD->fd >= 0 && !fdIsManaged(pollFD->fd)) {
+            someFDsAreUnmanaged = true;
+        }
+    }
+
+    std::chrono::steady_clock::time_point deadline;
+
+    if (timeout.count() >= 1) {
+        deadline = std::chrono::steady_clock::now() + timeout;
+    }
+
+    int pollSetFD = -1;
+    std::vector<pollfd> watchedPollFDs;
+
+    auto scopeGuard = MakeScopeGuard([&] () -> void {
+        if (pollSetFD >= 0) {
+            destroyPollSet(pollSetFD);
+        }
+    });
+
+    for (;;) {
+        int readyPollFDCount;
+
+        do {
+            readyPollFDCount = ::poll(pollFDs, numberOfPollFDs, 0);
+        } while (readyPollFDCount < 0 && errno == EINTR);
+
+        if (readyPollFDCount != 0 || timeout.count() == 0) {
+            return readyPollFDCount;
+        }
+
+        std::chrono::nanoseconds remainingTime = timeout;
+
+        if (timeout.count() >= 1) {
+            remainingTime = deadline - std::chrono::steady_clock::now();
+
+            if (remainingTime.count() <= 0) {
+                return 0;
+            }
+        }
+
+        if (someFDsAreUnmanaged) {
+            if (pollSetFD < 0) {
+                pollSetFD = createPollSet(pollFDs, numberOfPollFDs, &watchedPollFDs);
+
+                if (pollSetFD < 0) {
+                    return -1;
+                }
+            }
+
+            waitForFiles(watchedPollFDs.data(), watchedPollFDs.size(), remainingTime);
+        } else {
+            waitForFiles(pollFDs, numberOfPollFDs, remainingTime);
+        }
+    }
+}
+
+
+int
+Loop::createPollSet(const pollfd *pollFDs, nfds_t numberOfPollFDs
+                    , std::vector<pollfd> *watchedPollFDs)
+{
+    int fd = ::epoll_create1(EPOLL_CLOEXEC);
+
+    if (fd < 0) {
+        return -1;
+    }
+
+    auto scopeGuard = MakeScopeGuard([&] () -> void {
+        if (::close(fd) < 0 && errno != EINTR) {
+            std::perror("close() failed");
+            std::terminate();
+        }
+    });
+
+    watchedPollFDs->assign(pollFDs, pollFDs + numberOfPollFDs);
+
+    for (nfds_t i = 0; i < numberOfPollFDs; ++i) {
+        pollfd *pollFD = &(*watchedPollFDs)[i];
+
+        if (pollFD->fd < 0 || fdIsManaged(pollFD->fd)) {
+            continue;
+        }
+
+        epoll_event event = {};
+        event.data.fd = pollFD->fd;
+
+        for (nfds_t j = i; j < numberOfPollFDs; ++j) {
+            if (pollFDs[j].fd == pollFD->fd) {
+                event.events |= static_cast<std::uint16_t>(pollFDs[j].events);
+            }
+        }
+
+        if (::epoll_ctl(fd, EPOLL_CTL_ADD, pollFD->fd, &event) < 0 && errno != EEXIST) {
+            return -1;
+        }
+
+        pollFD->fd = -1;
+    }
+
+    watchedPollFDs->push_back({fd, POLLIN, 0});
+    createIOContext(fd, false, true);
+    scopeGuard.dismiss();
+    return fd;
+}
+
+
+void
+Loop::destroyPollSet(int fd) noexcept
+{
+    destroyIOContext(fd);
+
+    if (::close(fd) < 0 && errno != EINTR) {
+        std::perror("close() failed");
+        std::terminate();
+    }
+}
+
+
+template <class T, class ...U>
+ssize_t
+Loop::readFile(int fd, long timeout, T &&function, U &&...argument)
+{
+    for (;;) {
+        ssize_t numberOfBytes = function(fd, std::forward<U>(argument)...);
+
+        if (numberOfBytes < 0) {
+            if (errno == EAGAIN) {
+                if (!waitForFile(fd, IOCondition::In, nullptr
+                                 , std::chrono::microseconds(timeout))) {
+                    errno = EAGAIN;
+                    return -1;
+                }
+            } else {
+                if (errno != EINTR) {
+                    return -1;
+                }
+            }
+        } else {
+            return numberOfBytes;
+        }
+    }
+}
+
+
+template <class T, class ...U>
+ssize_t
+Loop::writeFile(int fd, long timeout, T &&function, U &&...argument)
+{
+    for (;;) {
+        ssize_t numberOfBytes = function(fd, std::forward<U>(argument)...);
+
+        if (numberOfBytes < 0) {
+            if (errno == EAGAIN) {
+                if (!waitForFile(fd, IOCondition::Out, nullptr
+                                 , std::chrono::microseconds(timeout))) {
+                    errno = EAGAIN;
+                    return -1;
+                }
+            } else {
+                if (errno != EINTR) {
+                    return -1;
+                }
+            }
+        } else {
+            return numberOfBytes;
+        }
+    }
+}
+
+
+template <class T, class ...U>
+ssize_t
+Loop::transferFile(int inFD, int outFD, T &&function, U &&...argument)
+{
+    for (;;) {
+        ssize_t numberOfBytes = function(std::forward<U>(argument)...);
+
+        if (numberOfBytes < 0) {
+            if (errno == EAGAIN) {
+                int fd;
+                IOCondition ioCondition;
+                long timeout;
+
+                if (inFD >= 0 && !FileIsReadable(inFD)) {
+                    fd = inFD;
+                    ioCondition = IOCondition::In;
+                    timeout = fdIsManaged(fd) ? getEffectiveReadTimeout(fd) : 0;
+                } else {
+                    fd = outFD;
+                    ioCondition = IOCondition::Out;
+                    timeout = fdIsManaged(fd) ? getEffectiveWriteTimeout(fd) : 0;
+                }
+
+                if (!waitForFile(fd, ioCondition, nullptr, std::chrono::microseconds(timeout))) {
+                    errno = EAGAIN;
+                    return -1;
+                }
+            } else {
+                if (errno != EINTR) {
+                    return -1;
+                }
+            }
+        } else {
+            return numberOfBytes;
+        }
+    }
+}
+
+
+const detail::FileOptions *
+Loop::getFileOptions(int fd) const noexcept
+{
+    return static_cast<const FileOptions *>(ioPoller_.getContextTag(fd));
+}
+
+
+detail::FileOptions *
+Loop::getFileOptions(int fd) noexcept
+{
+    return static_cast<FileOptions *>(ioPoller_.getContextTag(fd));
+}
+
+
+void
+Loop::createIOContext(int fd, bool isSocket, bool blocking, long readTimeout, long writeTimeout)
+{
+    ioPoller_.createContext(fd);
+    FileOptions *fileOptions = getFileOptions(fd);
+    fileOptions->isSocket = isSocket;
+    fileOptions->blocking = blocking;
+    fileOptions->readTimeout = readTimeout;
+    fileOptions->writeTimeout = writeTimeout;
+    fileOptions->writeBuffer = nullptr;
+    fileOptions->zeroCopyThreshold = 0;
+    fileOptions->zeroCopySequenceNumber = 0;
+    fileOptions->completedZeroCopySequenceNumber = 0;
+}
+
+
+void
+Loop::destroyIOContext(int fd) noexcept
+{
+    WriteBuffer *writeBuffer = getFileOptions(fd)->writeBuffer;
+
+    if (writeBuffer != nullptr) {
+        destroyWriteBuffer(writeBuffer);
+    }
+
+    ioPoller_.destroyContext(fd);
+}
+
+
+long
+Loop::getEffectiveReadTimeout(int fd) const noexcept
+{
+    const FileOptions *fileOptions = getFileOptions(fd);
+    return fileOptions->blocking ? fileOptions->readTimeout : 0;
+}
+
+
+long
+Loop::getEffectiveWriteTimeout(int fd) const noexcept
+{
+    const FileOptions *fileOptions = getFileOptions(fd);
+    return fileOptions->blocking ? fileOptions->writeTimeout : 0;
+}
+
+
+bool
+Loop::waitForFile(int fd, IOCondition ioConditions, IOCondition *readyIOConditions
+                  , std::chrono::nanoseconds timeout)
+{
+    if (timeout.count() < 0) {
+        struct {
+            IOCondition *readyIOConditions;
+            void *fiberHandle;
+            Scheduler *scheduler;
+        } context;
+
+        MyIOWatcher myIOWatcher;
+
+        myIOWatcher.callback = [&context] (IOCondition readyIOConditions) -> void {
+            if (context.readyIOConditions != nullptr) {
+                *context.readyIOConditions = readyIOConditions;
+            }
+
+            context.scheduler->resumeFiber(context.fiberHandle);
+        };
+
+        ioPoller_.addWatcher(&myIOWatcher, fd, ioConditions);
+
+        auto scopeGuard = MakeScopeGuard([&] () -> void {
+            ioPoller_.removeWatcher(&myIOWatcher);
+        });
+
+        context.readyIOConditions = readyIOConditions;
+        (context.scheduler = &scheduler_)->suspendFiber(context.fiberHandle = scheduler_
+                                                                              .getCurrentFiber());
+        return true;
     } else if (timeout.count() == 0) {
         return false;
     } else {
@@ -841,7 +1478,7 @@ Loop::waitForFile(int fd, IOCondition ioConditions, IOCondition *readyIOConditio
             context.scheduler->resumeFiber(context.fiberHandle);
         };
 
-        ioClock_.addTimer(&myIOTimer, timeout);
+        ioClock_.addTimer(&myIOTimer, timeout, timerSlack_);
 
         auto scopeGuard2 = MakeScopeGuard([&] () -> void {
             if (!context.isTimedOut) {
@@ -859,7 +1496,69 @@ Loop::waitForFile(int fd, IOCondition ioConditions, IOCondition *readyIOConditio
 
 
 void
-Loop::setDelay(std::chrono::milliseconds duration)
+Loop::waitForFiles(pollfd *pollFDs, nfds_t numberOfPollFDs, std::chrono::nanoseconds timeout)
+{
+    if (timeout.count() == 0) {
+        return;
+    }
+
+    struct {
+        bool isTimedOut;
+        void *fiberHandle;
+        Scheduler *scheduler;
+    } context;
+
+    std::unique_ptr<MyIOWatcher []> myIOWatchers(new MyIOWatcher[numberOfPollFDs]);
+    nfds_t myIOWatcherCount = 0;
+
+    auto scopeGuard1 = MakeScopeGuard([&] () -> void {
+        for (nfds_t i = 0; i < myIOWatcherCount; ++i) {
+            ioPoller_.removeWatcher(&myIOWatchers[i]);
+        }
+    });
+
+    for (nfds_t i = 0; i < numberOfPollFDs; ++i) {
+        pollfd *pollFD = &pollFDs[i];
+
+        if (pollFD->fd >= 0 && fdIsManaged(pollFD->fd)) {
+            MyIOWatcher *myIOWatcher = &myIOWatchers[myIOWatcherCount];
+
+            myIOWatcher->callback = [&context, pollFD] (IOCondition readyIOConditions) -> void {
+                pollFD->revents |= IOConditionsToPollEvents(readyIOConditions);
+                context.scheduler->resumeFiber(context.fiberHandle);
+            };
+
+            ioPoller_.addWatcher(myIOWatcher, pollFD->fd
+                                 , PollEventsToIOConditions(pollFD->events) | IOCondition::Err);
+            ++myIOWatcherCount;
+        }
+    }
+
+    MyIOTimer myIOTimer;
+
+    if (timeout.count() >= 1) {
+        myIOTimer.callback = [&context] () -> void {
+            context.isTimedOut = true;
+            context.scheduler->resumeFiber(context.fiberHandle);
+        };
+
+        ioClock_.addTimer(&myIOTimer, timeout, timerSlack_);
+    }
+
+    auto scopeGuard2 = MakeScopeGuard([&] () -> void {
+        if (timeout.count() >= 1 && !context.isTimedOut) {
+            ioClock_.removeTimer(&myIOTimer);
+        }
+    });
+
+    context.isTimedOut = false;
+    (context.scheduler = &scheduler_)->suspendFiber(context.fiberHandle = scheduler_
+                                                                          .getCurrentFiber());
+}
+
+
+void
+Loop::setDelay(std::chrono::nanoseconds duration, std::chrono::nanoseconds slack)
 {
     if (duration.count() < 0) {
         scheduler_.suspendFiber(scheduler_.getCurrentFiber());
@@ -877,7 +1576,7 @@ Loop::setDelay(std::chrono::milliseconds duration)
             context.scheduler->resumeFiber(context.fiberHandle);
         };
 
-        ioClock_.addTimer(&myIOTimer, duration);
+        ioClock_.addTimer(&myIOTimer, duration, slack);
 
         auto scopeGuard = MakeScopeGuard([&] () -> void {
             if (!context.isTimedOut) {
@@ -892,6 +1591,296 @@ Loop::setDelay(std::chrono::milliseconds duration)
 }
 
 
+ssize_t
+Loop::bufferFile(WriteBuffer *writeBuffer, long timeout, const iovec *vector, int vectorLength)
+{
+    if (writeBuffer->errorNumber != 0) {
+        errno = writeBuffer->errorNumber;
+        writeBuffer->errorNumber = 0;
+        return -1;
+    }
+
+    std::size_t dataSize = 0;
+
+    for (int i = 0; i < vectorLength; ++i) {
+        dataSize += vector[i].iov_len;
+    }
+
+    if (writeBuffer->data.getDataSize() + dataSize > writeBuffer->maxDataSize) {
+        return flushWriteBuffer(writeBuffer, timeout) < 0 ? -1 : 0;
+    }
+
+    for (int i = 0; i < vectorLength; ++i) {
+        writeBuffer->data.write(vector[i].iov_base, vector[i].iov_len);
+    }
+
+    if (!writeBuffer->isDirty) {
+        writeBuffer->isDirty = true;
+        dirtyWriteBufferList_.appendNode(writeBuffer);
+    }
+
+    return dataSize;
+}
+
+
+int
+Loop::flushWriteBuffer(WriteBuffer *writeBuffer, long timeout)
+{
+    Stream *data = &writeBuffer->data;
+
+    while (data->getDataSize() >= 1) {
+        ssize_t numberOfBytes;
+
+        if (writeBuffer->isSocket) {
+            numberOfBytes = ::send(writeBuffer->fd, data->getData(), data->getDataSize()
+                                   , MSG_NOSIGNAL);
+        } else {
+            numberOfBytes = ::write(writeBuffer->fd, data->getData(), data->getDataSize());
+        }
+
+        if (numberOfBytes < 0) {
+            if (errno == EAGAIN) {
+                if (!waitForFile(writeBuffer->fd, IOCondition::Out, nullptr
+                                 , std::chrono::microseconds(timeout))) {
+                    errno = EAGAIN;
+                    return -1;
+                }
+            } else {
+                if (errno != EINTR) {
+                    data->reset();
+                    return -1;
+                }
+            }
+        } else {
+            data->discardData(numberOfBytes);
+        }
+    }
+
+    return 0;
+}
+
+
+void
+Loop::flushWriteBuffers() noexcept
+{
+    while (!dirtyWriteBufferList_.isEmpty()) {
+        auto writeBuffer = static_cast<WriteBuffer *>(dirtyWriteBufferList_.getHead());
+        writeBuffer->remove();
+        writeBuffer->isDirty = false;
+        std::size_t dataSize = writeBuffer->data.getDataSize();
+
+        if (flushWriteBuffer(writeBuffer, 0) < 0) {
+            if (errno == EAGAIN) {
+                if (!writeBuffer->isWaiting) {
+                    ioPoller_.addWatcher(&writeBuffer->myIOWatcher, writeBuffer->fd
+                                         , IOCondition::Out);
+                    writeBuffer->isWaiting = true;
+                    ++numberOfWaitingWriteBuffers_;
+                }
+
+                long timeout = getFileOptions(writeBuffer->fd)->writeTimeout;
+
+                if (timeout >= 1 && (!writeBuffer->isTimed
+                                     || writeBuffer->data.getDataSize() < dataSize)) {
+                    if (writeBuffer->isTimed) {
+                        ioClock_.removeTimer(&writeBuffer->myIOTimer);
+                    }
+
+                    ioClock_.addTimer(&writeBuffer->myIOTimer, std::chrono::microseconds(timeout)
+                                      , timerSlack_);
+                    writeBuffer->isTimed = true;
+                }
+
+                continue;
+            }
+
+            writeBuffer->errorNumber = errno;
+        }
+
+        stopWaitingForWriteBuffer(writeBuffer);
+    }
+}
+
+
+void
+Loop::stopWaitingForWriteBuffer(WriteBuffer *writeBuffer) noexcept
+{
+    if (writeBuffer->isTimed) {
+        ioClock_.removeTimer(&writeBuffer->myIOTimer);
+        writeBuffer->isTimed = false;
+    }
+
+    if (writeBuffer->isWaiting) {
+        ioPoller_.removeWatcher(&writeBuffer->myIOWatcher);
+        writeBuffer->isWaiting = false;
+        --numberOfWaitingWriteBuffers_;
+    }
+}
+
+
+int
+Loop::finishWrites(int fd, long maxTimeout) noexcept
+{
+    const FileOptions *fileOptions = getFileOptions(fd);
+    WriteBuffer *writeBuffer = fileOptions->writeBuffer;
+    long timeout = getEffectiveWriteTimeout(fd);
+    int errorNumber = 0;
+
+    if (timeout < 0 || timeout > maxTimeout) {
+        timeout = maxTimeout;
+    }
+
+    try {
+        if (writeBuffer != nullptr) {
+            errorNumber = writeBuffer->errorNumber;
+
+            if (errorNumber == 0 && flushWriteBuffer(writeBuffer, timeout) < 0) {
+                errorNumber = errno;
+            }
+        }
+
+        if (errorNumber == 0
+            && waitForZeroCopyCompletions(fd, fileOptions->zeroCopySequenceNumber, timeout) < 0) {
+            errorNumber = errno;
+        }
+    } catch (FiberInterruption) {
+        interruptFiber(getCurrentFiber());
+        errorNumber = EINTR;
+    }
+
+    return errorNumber;
+}
+
+
+void
+Loop::destroyWriteBuffer(WriteBuffer *writeBuffer) noexcept
+{
+    if (writeBuffer->isDirty) {
+        writeBuffer->remove();
+    }
+
+    stopWaitingForWriteBuffer(writeBuffer);
+    delete writeBuffer;
+}
+
+
+ssize_t
+Loop::sendZeroCopy(int fd, long timeout, const void *data, size_t dataSize, int flags)
+{
+    for (;;) {
+        if (reapZeroCopyCompletions(fd) < 0) {
+            return -1;
+        }
+
+        ssize_t numberOfBytes = ::send(fd, data, dataSize, flags | MSG_ZEROCOPY);
+
+        if (numberOfBytes < 0) {
+            if (errno == EAGAIN) {
+                if (!waitForFile(fd, IOCondition::Out, nullptr
+                                 , std::chrono::microseconds(timeout))) {
+                    errno = EAGAIN;
+                    return -1;
+                }
+
+                if (!fdIsManaged(fd)) {
+                    errno = EBADF;
+                    return -1;
+                }
+            } else if (errno == ENOBUFS) {
+                return writeFile(fd, timeout, ::send, data, dataSize, flags);
+            } else {
+                if (errno != EINTR) {
+                    return -1;
+                }
+            }
+        } else {
+            ++getFileOptions(fd)->zeroCopySequenceNumber;
+            return numberOfBytes;
+        }
+    }
+}
+
+
+int
+Loop::waitForZeroCopyCompletions(int fd, std::uint32_t sequenceNumber, long timeout)
+{
+    for (;;) {
+        if (reapZeroCopyCompletions(fd) < 0) {
+            return -1;
+        }
+
+        const FileOptions *fileOptions = getFileOptions(fd);
+
+        if (static_cast<std::int32_t>(fileOptions->completedZeroCopySequenceNumber
+                                      - sequenceNumber) >= 0) {
+            return 0;
+        }
+
+        if (!waitForFile(fd, IOCondition::Err, nullptr, std::chrono::microseconds(timeout))) {
+            errno = timeout == 0 ? EAGAIN : ETIMEDOUT;
+            return -1;
+        }
+
+        if (!fdIsManaged(fd)) {
+            errno = EBADF;
+            return -1;
+        }
+    }
+}
+
+
+int
+Loop::reapZeroCopyCompletions(int fd) noexcept
+{
+    FileOptions *fileOptions = getFileOptions(fd);
+
+    if (fileOptions->completedZeroCopySequenceNumber == fileOptions->zeroCopySequenceNumber) {
+        return 0;
+    }
+
+    for (;;) {
+        char control[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+        msghdr message = {};
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        if (::recvmsg(fd, &message, MSG_ERRQUEUE) < 0) {
+            if (errno == EAGAIN) {
+                return 0;
+            } else {
+                if (errno != EINTR) {
+                    return -1;
+                }
+            }
+        } else {
+            for (cmsghdr *controlMessage = CMSG_FIRSTHDR(&message); controlMessage != nullptr
+                 ; controlMessage = CMSG_NXTHDR(&message, controlMessage)) {
+                if (!(controlMessage->cmsg_level == SOL_IP
+                      && controlMessage->cmsg_type == IP_RECVERR)
+                    && !(controlMessage->cmsg_level == SOL_IPV6
+                         && controlMessage->cmsg_type == IPV6_RECVERR)) {
+                    continue;
+                }
+
+                auto error = reinterpret_cast<const sock_extended_err *>(CMSG_DATA(controlMessage));
+
+                if (error->ee_errno != 0 || error->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                    continue;
+                }
+
+                std::uint32_t completedSequenceNumber = error->ee_data + 1;
+
+                if (static_cast<std::int32_t>(completedSequenceNumber
+                                              - fileOptions->completedZeroCopySequenceNumber)
+                    >= 1) {
+                    fileOptions->completedZeroCopySequenceNumber = completedSequenceNumber;
+                }
+            }
+        }
+    }
+}
+
+
 namespace {
 
 bool
@@ -933,7 +1922,7 @@ TimeToTimeout(timeval time)
     if (time.tv_sec == 0 && time.tv_usec == 0) {
         timeout = -1;
     } else {
-        timeout = time.tv_sec * 1000 + time.tv_usec / 1000;
+        timeout = time.tv_sec * 1000000 + time.tv_usec;
     }
 
     return timeout;
@@ -949,13 +1938,72 @@ TimeoutToTime(long timeout)
         time.tv_sec = 0;
         time.tv_usec = 0;
     } else {
-        time.tv_sec = timeout / 1000;
-        time.tv_usec = (timeout % 1000) * 1000;
+        time.tv_sec = timeout / 1000000;
+        time.tv_usec = timeout % 1000000;
     }
 
     return time;
 }
 
+
+
+std::chrono::nanoseconds
+TimeToDuration(timespec time)
+{
+    return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+}
+
+
+IOCondition
+PollEventsToIOConditions(short pollEvents)
+{
+    IOCondition ioConditions = IOCondition::No;
+
+    for (std::pair<short, IOCondition> x : {
+         std::make_pair(short(POLLIN), IOCondition::In),
+         std::make_pair(short(POLLOUT), IOCondition::Out),
+         std::make_pair(short(POLLRDHUP), IOCondition::RdHup),
+         std::make_pair(short(POLLPRI), IOCondition::Pri),
+    }) {
+        if ((pollEvents & x.first) == x.first) {
+            ioConditions |= x.second;
+        }
+    }
+
+    return ioConditions;
+}
+
+
+short
+IOConditionsToPollEvents(IOCondition ioConditions)
+{
+    short pollEvents = 0;
+
+    for (std::pair<IOCondition, short> x : {
+         std::make_pair(IOCondition::In, short(POLLIN)),
+         std::make_pair(IOCondition::Out, short(POLLOUT)),
+         std::make_pair(IOCondition::RdHup, short(POLLRDHUP)),
+         std::make_pair(IOCondition::Pri, short(POLLPRI)),
+         std::make_pair(IOCondition::Err, short(POLLERR)),
+         std::make_pair(IOCondition::Hup, short(POLLHUP)),
+    }) {
+        if ((ioConditions & x.first) == x.first) {
+            pollEvents |= x.second;
+        }
+    }
+
+    return pollEvents;
+}
+
+
+
+bool
+FileIsReadable(int fd) noexcept
+{
+    pollfd pollFD = {fd, POLLIN, 0};
+    return ::poll(&pollFD, 1, 0) != 0;
+}
+
 } // namespace
 
 } // namespace siren
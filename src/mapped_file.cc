@@ -0,0 +1,182 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <exception>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "async.h"
+#include "scope_guard.h"
+
+
+namespace siren {
+
+MappedFile::MappedFile(const char *fileName)
+{
+    SIREN_ASSERT(fileName != nullptr);
+    initialize(fileName);
+}
+
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+{
+    other.move(this);
+}
+
+
+MappedFile::~MappedFile()
+{
+    finalize();
+}
+
+
+MappedFile &
+MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (&other != this) {
+        finalize();
+        other.move(this);
+    }
+
+    return *this;
+}
+
+
+void
+MappedFile::initialize(const char *fileName)
+{
+    int fd = open(fileName, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "open() failed");
+    }
+
+    auto scopeGuard = MakeScopeGuard([&] () -> void {
+        if (close(fd) < 0 && errno != EINTR) {
+            std::perror("close() failed");
+            std::terminate();
+        }
+    });
+
+    struct stat status;
+
+    if (fstat(fd, &status) < 0) {
+        throw std::system_error(errno, std::system_category(), "fstat() failed");
+    }
+
+    size_ = status.st_size;
+
+    if (size_ == 0) {
+        data_ = nullptr;
+    } else {
+        data_ = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+
+        if (data_ == MAP_FAILED) {
+            throw std::system_error(errno, std::system_category(), "mmap() failed");
+        }
+    }
+}
+
+
+void
+MappedFile::finalize() noexcept
+{
+    if (data_ != nullptr) {
+        if (munmap(data_, size_) < 0) {
+            std::perror("munmap() failed");
+            std::terminate();
+        }
+    }
+}
+
+
+void
+MappedFile::move(MappedFile *other) noexcept
+{
+    other->data_ = data_;
+    other->size_ = size_;
+    data_ = nullptr;
+    size_ = 0;
+}
+
+
+bool
+MappedFile::isResident(std::size_t offset, std::size_t length) const
+{
+    char *pages;
+    std::size_t pagesSize;
+
+    if (!getPageRange(offset, length, &pages, &pagesSize)) {
+        return true;
+    }
+
+    std::size_t pageSize = sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> vector(pagesSize / pageSize);
+
+    if (mincore(pages, pagesSize, vector.data()) < 0) {
+        throw std::system_error(errno, std::system_category(), "mincore() failed");
+    }
+
+    for (unsigned char x : vector) {
+        if ((x & 1) == 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+void
+MappedFile::prefetch(Async *async, std::size_t offset, std::size_t length)
+{
+    SIREN_ASSERT(async != nullptr);
+    char *pages;
+    std::size_t pagesSize;
+
+    if (!getPageRange(offset, length, &pages, &pagesSize) || isResident(offset, length)) {
+        return;
+    }
+
+    std::size_t pageSize = sysconf(_SC_PAGESIZE);
+
+    async->executeTask([pages, pagesSize, pageSize] () -> void {
+        if (madvise(pages, pagesSize, MADV_WILLNEED) < 0) {
+            throw std::system_error(errno, std::system_category(), "madvise() failed");
+        }
+
+        for (std::size_t i = 0; i < pagesSize; i += pageSize) {
+            static_cast<const volatile char *>(pages)[i];
+        }
+    });
+}
+
+
+bool
+MappedFile::getPageRange(std::size_t offset, std::size_t length, char **pages
+                         , std::size_t *pagesSize) const noexcept
+{
+    SIREN_ASSERT(offset <= size_);
+
+    if (length > size_ - offset) {
+        length = size_ - offset;
+    }
+
+    if (length == 0) {
+        return false;
+    }
+
+    std::size_t pageSize = sysconf(_SC_PAGESIZE);
+    std::size_t pageOffset = offset / pageSize * pageSize;
+    *pages = static_cast<char *>(data_) + pageOffset;
+    *pagesSize = (offset + length - pageOffset + pageSize - 1) / pageSize * pageSize;
+    return true;
+}
+
+} // namespace siren
@@ -1,21 +1,38 @@
 #include "memory_pool.h"
 
 #include <cerrno>
+#include <climits>
+#include <cstdio>
 #include <cstdlib>
 #include <algorithm>
+#include <exception>
 #include <system_error>
 #include <utility>
 
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
 #include "utility.h"
 
 
 namespace siren {
 
+namespace {
+
+std::size_t GetSystemPageSize() noexcept;
+bool BindToLocalNUMANode(void *, std::size_t) noexcept;
+
+} // namespace
+
+
 MemoryPool::MemoryPool(std::size_t blockAlignment, std::size_t blockSize
                        , std::size_t minChunkLength) noexcept
   : blockAlignment_(std::max(NextPowerOfTwo(blockAlignment), std::size_t(1))),
     blockSize_(AlignSize(std::max(blockSize, sizeof(void *)), blockAlignment_)),
-    minChunkSize_(NextPowerOfTwo(std::max(minChunkLength, std::size_t(1)) * blockSize_))
+    minChunkSize_(NextPowerOfTwo(std::max(minChunkLength, std::size_t(1)) * blockSize_)),
+    isNUMALocal_(false)
 {
     SIREN_ASSERT(blockAlignment_ <= alignof(std::max_align_t));
     initialize();
@@ -26,7 +43,8 @@ MemoryPool::MemoryPool(MemoryPool &&other) noexcept
   : blockAlignment_(other.blockAlignment_),
     blockSize_(other.blockSize_),
     minChunkSize_(other.minChunkSize_),
-    chunks_(std::move(other.chunks_))
+    chunks_(std::move(other.chunks_)),
+    isNUMALocal_(other.isNUMALocal_)
 {
     other.move(this);
 }
@@ -47,6 +65,7 @@ MemoryPool::operator=(MemoryPool &&other) noexcept
         SIREN_ASSERT(blockSize_ == other.blockSize_);
         SIREN_ASSERT(minChunkSize_ == other.minChunkSize_);
         chunks_ = std::move(other.chunks_);
+        isNUMALocal_ = other.isNUMALocal_;
         other.move(this);
     }
 
@@ -68,8 +87,11 @@ MemoryPool::initialize() noexcept
 void
 MemoryPool::finalize() noexcept
 {
+    std::size_t chunkSize = minChunkSize_;
+
     for (void *chunk : chunks_) {
-        std::free(chunk);
+        freeChunk(chunk, chunkSize);
+        chunkSize *= 2;
     }
 }
 
@@ -104,12 +126,7 @@ MemoryPool::makeBlock()
     } else {
         chunks_.reserve(chunks_.size() + 1);
         std::size_t chunkSize = nextChunkSize_;
-        block = std::malloc(chunkSize);
-
-        if (block == nullptr) {
-            throw std::system_error(errno, std::system_category(), "malloc() failed");
-        }
-
+        block = allocateChunk(chunkSize);
         chunks_.push_back(block);
         nextChunkSize_ = 2 * chunkSize;
         lastNewBlock_ = static_cast<char *>(block) + chunkSize - blockSize_;
@@ -119,4 +136,80 @@ MemoryPool::makeBlock()
     return block;
 }
 
+
+void *
+MemoryPool::allocateChunk(std::size_t chunkSize)
+{
+    if (!isNUMALocal_) {
+        void *chunk = std::malloc(chunkSize);
+
+        if (chunk == nullptr) {
+            throw std::system_error(errno, std::system_category(), "malloc() failed");
+        }
+
+        return chunk;
+    }
+
+    std::size_t mappingSize = AlignSize(chunkSize, GetSystemPageSize());
+    void *chunk = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE
+                       , -1, 0);
+
+    if (chunk == MAP_FAILED) {
+        throw std::system_error(errno, std::system_category(), "mmap() failed");
+    }
+
+    if (!BindToLocalNUMANode(chunk, mappingSize)) {
+        std::size_t pageSize = GetSystemPageSize();
+
+        for (std::size_t i = 0; i < mappingSize; i += pageSize) {
+            static_cast<volatile char *>(chunk)[i] = 0;
+        }
+    }
+
+    return chunk;
+}
+
+
+void
+MemoryPool::freeChunk(void *chunk, std::size_t chunkSize) noexcept
+{
+    if (!isNUMALocal_) {
+        std::free(chunk);
+        return;
+    }
+
+    if (munmap(chunk, AlignSize(chunkSize, GetSystemPageSize())) < 0) {
+        std::perror("munmap() failed");
+        std::terminate();
+    }
+}
+
+
+namespace {
+
+std::size_t
+GetSystemPageSize() noexcept
+{
+    static const std::size_t systemPageSize = sysconf(_SC_PAGESIZE);
+    return systemPageSize;
+}
+
+
+bool
+BindToLocalNUMANode(void *address, std::size_t size) noexcept
+{
+    unsigned int numaNode;
+
+    if (syscall(SYS_getcpu, nullptr, &numaNode, nullptr) < 0
+        || numaNode >= sizeof(unsigned long) * CHAR_BIT) {
+        return false;
+    }
+
+    unsigned long nodeMask = 1UL << numaNode;
+    return syscall(SYS_mbind, address, size, MPOL_PREFERRED, &nodeMask
+                   , sizeof(nodeMask) * CHAR_BIT + 1, 0) == 0;
+}
+
+} // namespace
+
 } // namespace siren
@@ -0,0 +1,213 @@
+#include "tcp_server.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <exception>
+#include <system_error>
+#include <utility>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "assert.h"
+#include "list.h"
+#include "loop.h"
+#include "scope_guard.h"
+#include "tcp_socket.h"
+
+
+namespace siren {
+
+namespace detail {
+
+struct TCPServerWorker
+{
+    Loop loop;
+    TCPSocket listener;
+    int eventFD;
+    bool isStopped;
+    List connectionList;
+
+    explicit TCPServerWorker(std::size_t defaultFiberSize)
+      : loop(defaultFiberSize),
+        listener(&loop),
+        eventFD(-1),
+        isStopped(false)
+    {
+    }
+};
+
+
+struct TCPServerConnection
+  : ListNode
+{
+    void *fiberHandle;
+    bool isListed;
+};
+
+} // namespace detail
+
+
+TCPServer::TCPServer(const IPEndpoint &ipEndpoint, const Handler &handler
+                     , std::size_t numberOfThreads, int backlog, const ErrorHandler &errorHandler
+                     , std::size_t defaultFiberSize)
+  : handler_(handler),
+    errorHandler_(errorHandler)
+{
+    SIREN_ASSERT(handler != nullptr);
+
+    auto scopeGuard = MakeScopeGuard([&] () -> void {
+        stop();
+        finalize();
+    });
+
+    if (numberOfThreads == 0) {
+        numberOfThreads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+
+    start(ipEndpoint, numberOfThreads, backlog, defaultFiberSize);
+    scopeGuard.dismiss();
+}
+
+
+TCPServer::~TCPServer()
+{
+    stop();
+    finalize();
+}
+
+
+void
+TCPServer::finalize() noexcept
+{
+    for (std::unique_ptr<Worker> &worker : workers_) {
+        if (worker->eventFD >= 0 && worker->loop.close(worker->eventFD) < 0 && errno != EINTR) {
+            std::perror("close() failed");
+            std::terminate();
+        }
+    }
+
+    workers_.clear();
+}
+
+
+void
+TCPServer::start(const IPEndpoint &ipEndpoint, std::size_t numberOfThreads, int backlog
+                 , std::size_t defaultFiberSize)
+{
+    localEndpoint_ = ipEndpoint;
+    workers_.reserve(numberOfThreads);
+
+    for (std::size_t i = 0; i < numberOfThreads; ++i) {
+        workers_.emplace_back(new Worker(defaultFiberSize));
+        Worker *worker = workers_.back().get();
+        worker->listener.setReuseAddress(true);
+        worker->listener.setReusePort(true);
+        worker->listener.listen(localEndpoint_, backlog);
+
+        if (i == 0) {
+            localEndpoint_ = worker->listener.getLocalEndpoint();
+        }
+
+        int eventFD = eventfd(0, EFD_CLOEXEC);
+
+        if (eventFD < 0) {
+            throw std::system_error(errno, std::system_category(), "eventfd() failed");
+        }
+
+        auto scopeGuard = MakeScopeGuard([&] () -> void {
+            if (close(eventFD) < 0 && errno != EINTR) {
+                std::perror("close() failed");
+                std::terminate();
+            }
+        });
+
+        worker->loop.manageFD(eventFD);
+        worker->eventFD = eventFD;
+        scopeGuard.dismiss();
+    }
+
+    threads_.reserve(numberOfThreads);
+
+    for (std::unique_ptr<Worker> &worker : workers_) {
+        threads_.emplace_back(&TCPServer::worker, this, worker.get());
+    }
+}
+
+
+void
+TCPServer::stop() noexcept
+{
+    for (std::size_t i = 0; i < threads_.size(); ++i) {
+        std::uint64_t dummy = 1;
+
+        if (write(workers_[i]->eventFD, &dummy, sizeof(dummy)) < 0) {
+            std::perror("write() failed");
+            std::terminate();
+        }
+    }
+
+    for (std::thread &thread : threads_) {
+        thread.join();
+    }
+
+    threads_.clear();
+}
+
+
+void
+TCPServer::worker(Worker *worker) noexcept
+{
+    Loop *loop = &worker->loop;
+
+    void *fiberHandle = loop->createFiber([this, worker, loop] () -> void {
+        worker->listener.serve([this, worker, loop] (TCPSocket subSocket, IPEndpoint ipEndpoint)
+                               -> void {
+            if (worker->isStopped) {
+                return;
+            }
+
+            detail::TCPServerConnection connection;
+            connection.fiberHandle = loop->getCurrentFiber();
+            worker->connectionList.appendNode(&connection);
+            connection.isListed = true;
+
+            auto scopeGuard = MakeScopeGuard([&] () -> void {
+                if (connection.isListed) {
+                    connection.remove();
+                }
+            });
+
+            try {
+                handler_(loop, std::move(subSocket), ipEndpoint);
+            } catch (FiberInterruption) {
+                throw;
+            } catch (...) {
+                if (errorHandler_ != nullptr) {
+                    errorHandler_(loop, ipEndpoint, std::current_exception());
+                }
+            }
+        });
+    });
+
+    loop->createFiber([worker, loop, fiberHandle] () -> void {
+        std::uint64_t dummy;
+        loop->read(worker->eventFD, &dummy, sizeof(dummy));
+        worker->isStopped = true;
+        loop->interruptFiber(fiberHandle);
+
+        while (!worker->connectionList.isEmpty()) {
+            auto connection = static_cast<detail::TCPServerConnection *>(worker->connectionList
+                                                                         .getHead());
+            connection->remove();
+            connection->isListed = false;
+            loop->interruptFiber(connection->fiberHandle);
+        }
+    });
+
+    loop->run();
+}
+
+} // namespace siren
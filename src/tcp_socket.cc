@@ -1,20 +1,32 @@
 #include "tcp_socket.h"
 
 #include <cerrno>
+#include <cstdint>
+#include <cstring>
 #include <algorithm>
 #include <system_error>
+#include <utility>
 
+#include <fcntl.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <sys/socket.h>
 
 #include "assert.h"
 #include "loop.h"
+#include "scope_guard.h"
 #include "stream.h"
 
 
 namespace siren {
 
+namespace {
+
+bool NameToIPEndpoint(const sockaddr_storage &, IPEndpoint *) noexcept;
+
+} // namespace
+
+
 TCPSocket::TCPSocket(Loop *loop)
   : loop_(loop)
 {
@@ -72,7 +84,7 @@ TCPSocket::initialize()
 void
 TCPSocket::finalize() noexcept
 {
-    if (loop_->close(fd_) < 0 && errno != EINTR) {
+    if (loop_->close(fd_) < 0 && errno != EINTR && errno != ECOMM) {
         std::perror("close() failed");
         std::terminate();
     }
@@ -98,6 +110,17 @@ TCPSocket::setReuseAddress(bool reuseAddress)
 }
 
 
+void
+TCPSocket::setReusePort(bool reusePort)
+{
+    int onOff = reusePort;
+
+    if (setsockopt(fd_, SOL_SOCKET, SO_REUSEPORT, &onOff, sizeof(onOff)) < 0) {
+        throw std::system_error(errno, std::system_category(), "setsockopt(SO_REUSEPORT) failed");
+    }
+}
+
+
 void
 TCPSocket::setNoDelay(bool noDelay)
 {
@@ -201,6 +224,54 @@ TCPSocket::setSendBufferSize(int sendBufferSize)
 }
 
 
+void
+TCPSocket::setWriteCoalescing(std::size_t maxDataSize)
+{
+    SIREN_ASSERT(isValid());
+
+    if (loop_->setWriteCoalescing(fd_, maxDataSize) < 0) {
+        throw std::system_error(errno, std::system_category(), "setWriteCoalescing() failed");
+    }
+}
+
+
+void
+TCPSocket::setZeroCopy(std::size_t threshold)
+{
+    SIREN_ASSERT(isValid());
+
+    if (loop_->setZeroCopy(fd_, threshold) < 0) {
+        throw std::system_error(errno, std::system_category(), "setsockopt(SO_ZEROCOPY) failed");
+    }
+}
+
+
+std::uint32_t
+TCPSocket::getZeroCopySequenceNumber() const
+{
+    SIREN_ASSERT(isValid());
+    std::uint32_t sequenceNumber;
+
+    if (loop_->getZeroCopySequenceNumber(fd_, &sequenceNumber) < 0) {
+        throw std::system_error(errno, std::system_category()
+                                , "getZeroCopySequenceNumber() failed");
+    }
+
+    return sequenceNumber;
+}
+
+
+void
+TCPSocket::waitForZeroCopy(std::uint32_t sequenceNumber)
+{
+    SIREN_ASSERT(isValid());
+
+    if (loop_->waitForZeroCopy(fd_, sequenceNumber) < 0) {
+        throw std::system_error(errno, std::system_category(), "waitForZeroCopy() failed");
+    }
+}
+
+
 void
 TCPSocket::listen(const IPEndpoint &ipEndpoint, int backlog)
 {
@@ -240,6 +311,111 @@ TCPSocket::accept(IPEndpoint *ipEndpoint)
 }
 
 
+std::size_t
+TCPSocket::acceptMany(std::vector<TCPSocket> *subSockets, std::vector<IPEndpoint> *ipEndpoints
+                      , std::size_t maxNumberOfSubSockets)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(subSockets != nullptr);
+    SIREN_ASSERT(maxNumberOfSubSockets >= 1);
+    int subFDs[64];
+    sockaddr_storage names[64];
+    maxNumberOfSubSockets = std::min(maxNumberOfSubSockets, sizeof(subFDs) / sizeof(*subFDs));
+    subSockets->reserve(subSockets->size() + maxNumberOfSubSockets);
+
+    if (ipEndpoints != nullptr) {
+        ipEndpoints->reserve(ipEndpoints->size() + maxNumberOfSubSockets);
+    }
+
+    int numberOfSubFDs = loop_->acceptMany(fd_, subFDs, ipEndpoints == nullptr ? nullptr : names
+                                           , maxNumberOfSubSockets);
+
+    if (numberOfSubFDs < 0) {
+        throw std::system_error(errno, std::system_category(), "accept() failed");
+    }
+
+    std::size_t numberOfSubSockets = 0;
+
+    for (int i = 0; i < numberOfSubFDs; ++i) {
+        TCPSocket subSocket(loop_, subFDs[i]);
+
+        if (ipEndpoints != nullptr) {
+            IPEndpoint ipEndpoint;
+
+            if (!NameToIPEndpoint(names[i], &ipEndpoint)) {
+                continue;
+            }
+
+            ipEndpoints->push_back(ipEndpoint);
+        }
+
+        subSockets->push_back(std::move(subSocket));
+        ++numberOfSubSockets;
+    }
+
+    return numberOfSubSockets;
+}
+
+
+void
+TCPSocket::serve(const std::function<void (TCPSocket, IPEndpoint)> &handler
+                 , std::size_t maxNumberOfSubSockets, std::size_t fiberSize)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(handler != nullptr);
+    SIREN_ASSERT(maxNumberOfSubSockets >= 1);
+    std::vector<TCPSocket> subSockets;
+    std::vector<IPEndpoint> ipEndpoints;
+    useconds_t backoffDuration = 1000;
+
+    for (;;) {
+        try {
+            acceptMany(&subSockets, &ipEndpoints, maxNumberOfSubSockets);
+            backoffDuration = 1000;
+        } catch (FiberInterruption) {
+            return;
+        } catch (const std::system_error &exception) {
+            int errorNumber = exception.code().value();
+
+            if (errorNumber == ECONNABORTED || errorNumber == EPROTO || errorNumber == EINTR) {
+                continue;
+            }
+
+            if (errorNumber != EMFILE && errorNumber != ENFILE && errorNumber != ENOBUFS
+                && errorNumber != ENOMEM) {
+                throw;
+            }
+
+            try {
+                loop_->usleep(backoffDuration);
+            } catch (FiberInterruption) {
+                return;
+            }
+
+            backoffDuration = std::min(2 * backoffDuration, useconds_t(100000));
+            continue;
+        }
+
+        auto scopeGuard = MakeScopeGuard([&] () -> void {
+            subSockets.clear();
+            ipEndpoints.clear();
+        });
+
+        for (std::size_t i = 0; i < subSockets.size(); ++i) {
+            int subFD = subSockets[i].fd_;
+            IPEndpoint ipEndpoint = ipEndpoints[i];
+            Loop *loop = loop_;
+
+            loop_->createFiber([loop, handler, subFD, ipEndpoint] () -> void {
+                handler(TCPSocket(loop, subFD), ipEndpoint);
+            }, fiberSize);
+
+            subSockets[i].fd_ = -1;
+        }
+    }
+}
+
+
 void
 TCPSocket::connect(const IPEndpoint &ipEndpoint)
 {
@@ -331,12 +507,95 @@ TCPSocket::write(Stream *stream)
 {
     SIREN_ASSERT(isValid());
     SIREN_ASSERT(stream != nullptr);
+    std::uint32_t zeroCopySequenceNumber = getZeroCopySequenceNumber();
     std::size_t numberOfBytes = write(stream->getData(), stream->getDataSize());
+
+    if (getZeroCopySequenceNumber() != zeroCopySequenceNumber) {
+        waitForZeroCopy(getZeroCopySequenceNumber());
+    }
+
     stream->discardData(numberOfBytes);
     return numberOfBytes;
 }
 
 
+void
+TCPSocket::flush()
+{
+    SIREN_ASSERT(isValid());
+
+    if (loop_->flush(fd_) < 0) {
+        throw std::system_error(errno, std::system_category(), "flush() failed");
+    }
+}
+
+
+std::size_t
+TCPSocket::sendFile(int fd, off_t *offset, std::size_t size)
+{
+    SIREN_ASSERT(isValid());
+    ssize_t numberOfBytes = loop_->sendfile(fd_, fd, offset, size);
+
+    if (numberOfBytes < 0) {
+        throw std::system_error(errno, std::system_category(), "sendfile() failed");
+    }
+
+    return numberOfBytes;
+}
+
+
+std::size_t
+TCPSocket::relay(TCPSocket *other)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(other != nullptr && other->isValid());
+    SIREN_ASSERT(other->loop_ == loop_);
+    int fds[2];
+
+    if (loop_->pipe2(fds, O_CLOEXEC) < 0) {
+        throw std::system_error(errno, std::system_category(), "pipe2() failed");
+    }
+
+    auto scopeGuard = MakeScopeGuard([&] () -> void {
+        for (int fd : fds) {
+            if (loop_->close(fd) < 0 && errno != EINTR) {
+                std::perror("close() failed");
+                std::terminate();
+            }
+        }
+    });
+
+    std::size_t byteCount = 0;
+
+    for (;;) {
+        ssize_t numberOfBytes = loop_->splice(fd_, nullptr, fds[1], nullptr, 65536
+                                              , SPLICE_F_MOVE | SPLICE_F_MORE);
+
+        if (numberOfBytes < 0) {
+            throw std::system_error(errno, std::system_category(), "splice() failed");
+        }
+
+        if (numberOfBytes == 0) {
+            return byteCount;
+        }
+
+        for (ssize_t pendingByteCount = numberOfBytes; pendingByteCount >= 1;) {
+            ssize_t numberOfBytes2 = loop_->splice(fds[0], nullptr, other->fd_, nullptr
+                                                   , pendingByteCount
+                                                   , SPLICE_F_MOVE | SPLICE_F_MORE);
+
+            if (numberOfBytes2 < 0) {
+                throw std::system_error(errno, std::system_category(), "splice() failed");
+            }
+
+            pendingByteCount -= numberOfBytes2;
+        }
+
+        byteCount += numberOfBytes;
+    }
+}
+
+
 void
 TCPSocket::closeRead()
 {
@@ -352,10 +611,42 @@ void
 TCPSocket::closeWrite()
 {
     SIREN_ASSERT(isValid());
+    flush();
 
     if (shutdown(fd_, SHUT_WR) < 0) {
         throw std::system_error(errno, std::system_category(), "shutdown(SHUT_WR) failed");
     }
 }
 
+
+namespace {
+
+bool
+NameToIPEndpoint(const sockaddr_storage &name, IPEndpoint *ipEndpoint) noexcept
+{
+    if (name.ss_family == AF_INET) {
+        *ipEndpoint = IPEndpoint(reinterpret_cast<const sockaddr_in &>(name));
+        return true;
+    }
+
+    if (name.ss_family != AF_INET6) {
+        return false;
+    }
+
+    auto &name2 = reinterpret_cast<const sockaddr_in6 &>(name);
+
+    if (!IN6_IS_ADDR_V4MAPPED(&name2.sin6_addr)) {
+        return false;
+    }
+
+    sockaddr_in name3 = {};
+    name3.sin_family = AF_INET;
+    name3.sin_port = name2.sin6_port;
+    std::memcpy(&name3.sin_addr, &name2.sin6_addr.s6_addr[12], sizeof(name3.sin_addr));
+    *ipEndpoint = IPEndpoint(name3);
+    return true;
+}
+
+} // namespace
+
 } // namespace siren
@@ -1,18 +1,39 @@
 #include "thread_pool.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <climits>
 #include <cstdint>
 #include <cstdio>
+#include <ctime>
 #include <system_error>
 
+#include <linux/futex.h>
+#include <pthread.h>
 #include <sys/eventfd.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
 #include "config.h"
+#include "utility.h"
 
 
 namespace siren {
 
+namespace {
+
+const std::size_t NumberOfThreadPoolLanes = 2;
+
+std::int64_t GetTime() noexcept;
+bool FutexWait(std::atomic<std::uint32_t> *, std::uint32_t, long) noexcept;
+void FutexWake(std::atomic<std::uint32_t> *, int) noexcept;
+
+thread_local detail::ThreadPoolWorker *CurrentThreadPoolWorker = nullptr;
+thread_local ThreadPoolTask *CurrentThreadPoolTask = nullptr;
+
+} // namespace
+
+
 ThreadPoolTask::~ThreadPoolTask()
 {
     SIREN_ASSERT(state_.load(std::memory_order_relaxed) == State::Initial);
@@ -34,19 +55,32 @@ ThreadPoolTask::check()
 }
 
 
-ThreadPool::ThreadPool(std::size_t numberOfThreads)
+bool
+ThreadPool::CurrentTaskIsCancelled() noexcept
 {
-    initialize();
+    Task *task = CurrentThreadPoolTask;
+    return task != nullptr && task->isCancelled_.load(std::memory_order_relaxed);
+}
+
+
+ThreadPool::ThreadPool(std::size_t minNumberOfThreads, std::size_t queueCapacity
+                       , std::size_t maxNumberOfThreads)
+{
+    if (queueCapacity == 0) {
+        queueCapacity = 16384;
+    }
+
+    initialize(queueCapacity);
 
     auto scopeGuard = MakeScopeGuard([&] () -> void {
         finalize();
     });
 
-    if (numberOfThreads == 0) {
-        numberOfThreads = std::thread::hardware_concurrency();
+    if (minNumberOfThreads == 0) {
+        minNumberOfThreads = std::thread::hardware_concurrency();
     }
 
-    start(numberOfThreads);
+    start(minNumberOfThreads, std::max(maxNumberOfThreads, minNumberOfThreads));
     scopeGuard.dismiss();
 }
 
@@ -59,8 +93,41 @@ ThreadPool::~ThreadPool()
 
 
 void
-ThreadPool::initialize()
+ThreadPool::initialize(std::size_t queueCapacity)
 {
+    queueCapacity = NextPowerOfTwo(std::max(queueCapacity, std::size_t(2)));
+    queues_.reset(new Queue[NumberOfThreadPoolLanes]);
+
+    for (std::size_t i = 0; i < NumberOfThreadPoolLanes; ++i) {
+        Queue *queue = &queues_[i];
+        queue->slots.reset(new Slot[queueCapacity]);
+        queue->slotIndexMask = queueCapacity - 1;
+
+        for (std::size_t j = 0; j < queueCapacity; ++j) {
+            queue->slots[j].sequenceNumber.store(j, std::memory_order_relaxed);
+            queue->slots[j].task.store(nullptr, std::memory_order_relaxed);
+        }
+
+        queue->enqueuePosition.store(0, std::memory_order_relaxed);
+        queue->dequeuePosition.store(0, std::memory_order_relaxed);
+    }
+
+    numberOfBulkThreads_.store(0, std::memory_order_relaxed);
+    numberOfReservedThreads_.store(1, std::memory_order_relaxed);
+    wakeupCount_.store(0, std::memory_order_relaxed);
+    numberOfSleepingThreads_.store(0, std::memory_order_relaxed);
+    taskWakeupCount_.store(0, std::memory_order_relaxed);
+    numberOfTaskWaiters_.store(0, std::memory_order_relaxed);
+    monitorWakeupCount_.store(0, std::memory_order_relaxed);
+    monitorIsIdle_.store(false, std::memory_order_relaxed);
+    numberOfSpawnFailures_.store(0, std::memory_order_relaxed);
+    isStopped_.store(false, std::memory_order_relaxed);
+    completedTaskStack_.store(nullptr, std::memory_order_relaxed);
+    numberOfThreads_.store(0, std::memory_order_relaxed);
+    spawnDelay_.store(1000000, std::memory_order_relaxed);
+    idleTimeout_.store(10000, std::memory_order_relaxed);
+    lastSpawnTime_.store(0, std::memory_order_relaxed);
+    hasCPUAffinity_ = false;
     eventFD_ = eventfd(0, 0);
 
     if (eventFD_ < 0) {
@@ -80,17 +147,36 @@ ThreadPool::finalize() noexcept
 
 
 void
-ThreadPool::start(std::size_t numberOfThreads)
+ThreadPool::start(std::size_t minNumberOfThreads, std::size_t maxNumberOfThreads)
 {
-    threads_.reserve(numberOfThreads);
-    threads_.emplace_back(&ThreadPool::worker, this);
+    workers_.reset(new Worker[maxNumberOfThreads]);
+    numberOfWorkers_ = maxNumberOfThreads;
+    minNumberOfThreads_ = minNumberOfThreads;
+
+    for (std::size_t i = 0; i < maxNumberOfThreads; ++i) {
+        Worker *worker = &workers_[i];
+        worker->threadPool = this;
+        worker->top.store(0, std::memory_order_relaxed);
+        worker->bottom.store(0, std::memory_order_relaxed);
+        worker->slotIndexMask = 0;
+        worker->randomNumber = i + 1;
+        worker->isAlive.store(false, std::memory_order_relaxed);
+        worker->numberOfDequeuedTasks.store(0, std::memory_order_relaxed);
+        worker->queueLatency.store(0, std::memory_order_relaxed);
+    }
+
+    threads_.resize(maxNumberOfThreads);
 
     auto scopeGuard = MakeScopeGuard([&] () -> void {
         stop();
     });
 
-    while (--numberOfThreads >= 1) {
-        threads_.emplace_back(&ThreadPool::worker, this);
+    while (minNumberOfThreads-- >= 1) {
+        spawnThread();
+    }
+
+    if (maxNumberOfThreads > minNumberOfThreads_) {
+        monitorThread_ = std::thread(&ThreadPool::monitor, this);
     }
 
     scopeGuard.dismiss();
@@ -102,42 +188,318 @@ ThreadPool::stop() noexcept
 {
     noMoreWaitingTasks();
 
+    if (monitorThread_.joinable()) {
+        monitorThread_.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lockGuard(mutex_);
+    }
+
     for (std::thread &thread : threads_) {
-        thread.join();
+        if (thread.joinable()) {
+            thread.join();
+        }
     }
 }
 
 
 void
-ThreadPool::worker() noexcept
+ThreadPool::spawnThread()
+{
+    constexpr std::size_t k = 4096;
+
+    std::thread retiredThread;
+
+    auto scopeGuard1 = MakeScopeGuard([&] () -> void {
+        if (retiredThread.joinable()) {
+            retiredThread.join();
+        }
+    });
+
+    std::lock_guard<std::mutex> lockGuard(mutex_);
+
+    if (isStopped_.load(std::memory_order_relaxed)
+        || numberOfThreads_.load(std::memory_order_relaxed) >= numberOfWorkers_) {
+        return;
+    }
+
+    for (std::size_t i = 0; i < numberOfWorkers_; ++i) {
+        Worker *worker = &workers_[i];
+
+        if (worker->isAlive.load(std::memory_order_acquire)) {
+            continue;
+        }
+
+        retiredThread = std::move(threads_[i]);
+
+        if (worker->slots == nullptr) {
+            worker->slots.reset(new std::atomic<Task *>[k]);
+            worker->slotIndexMask = k - 1;
+
+            for (std::size_t j = 0; j < k; ++j) {
+                worker->slots[j].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        worker->isAlive.store(true, std::memory_order_relaxed);
+        numberOfThreads_.fetch_add(1, std::memory_order_relaxed);
+
+        auto scopeGuard2 = MakeScopeGuard([&] () -> void {
+            numberOfThreads_.fetch_sub(1, std::memory_order_relaxed);
+            worker->isAlive.store(false, std::memory_order_relaxed);
+        });
+
+        threads_[i] = std::thread(&ThreadPool::worker, this, worker);
+        scopeGuard2.dismiss();
+
+        if (hasCPUAffinity_) {
+            int errorNumber = pthread_setaffinity_np(threads_[i].native_handle()
+                                                     , sizeof(cpuAffinity_), &cpuAffinity_);
+
+            if (errorNumber != 0) {
+                throw std::system_error(errorNumber, std::system_category()
+                                        , "pthread_setaffinity_np() failed");
+            }
+        }
+
+        return;
+    }
+}
+
+
+void
+ThreadPool::adjustNumberOfThreads() noexcept
+{
+    if (numberOfThreads_.load(std::memory_order_relaxed) >= numberOfWorkers_
+        || numberOfSleepingThreads_.load(std::memory_order_relaxed) >= 1) {
+        return;
+    }
+
+    std::int64_t time = GetTime();
+    std::int64_t spawnDelay = spawnDelay_.load(std::memory_order_relaxed);
+    bool taskIsWaiting = false;
+    std::size_t i;
+
+    for (i = 0; i < NumberOfThreadPoolLanes; ++i) {
+        Queue *queue = &queues_[i];
+        std::size_t position = queue->dequeuePosition.load(std::memory_order_relaxed);
+        Slot *slot = &queue->slots[position & queue->slotIndexMask];
+
+        if (slot->sequenceNumber.load(std::memory_order_acquire) == position + 1) {
+            if (time - slot->enqueueTime.load(std::memory_order_relaxed) >= spawnDelay) {
+                break;
+            }
+
+            taskIsWaiting = true;
+        }
+    }
+
+    if (i == NumberOfThreadPoolLanes) {
+        if (taskIsWaiting && monitorIsIdle_.load(std::memory_order_relaxed)
+            && monitorIsIdle_.exchange(false, std::memory_order_relaxed)) {
+            monitorWakeupCount_.fetch_add(1, std::memory_order_release);
+            FutexWake(&monitorWakeupCount_, 1);
+        }
+
+        return;
+    }
+
+    std::int64_t lastSpawnTime = lastSpawnTime_.load(std::memory_order_relaxed);
+
+    if (time - lastSpawnTime < spawnDelay
+        || !lastSpawnTime_.compare_exchange_strong(lastSpawnTime, time
+                                                   , std::memory_order_relaxed)) {
+        return;
+    }
+
+    try {
+        spawnThread();
+    } catch (const std::exception &) {
+        numberOfSpawnFailures_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+
+void
+ThreadPool::monitor() noexcept
 {
     for (;;) {
-        ThreadPoolTask *task = removeWaitingTask();
+        std::uint32_t monitorWakeupCount = monitorWakeupCount_.load(std::memory_order_acquire);
+
+        if (isStopped_.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        long timeout = -1;
+
+        if (hasWaitingTasks()) {
+            std::int64_t spawnDelay = spawnDelay_.load(std::memory_order_relaxed);
+            timeout = std::max<std::int64_t>((spawnDelay + 999999) / 1000000, 1);
+        } else {
+            monitorIsIdle_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (hasWaitingTasks()) {
+                monitorIsIdle_.store(false, std::memory_order_relaxed);
+                continue;
+            }
+        }
+
+        FutexWait(&monitorWakeupCount_, monitorWakeupCount, timeout);
+        monitorIsIdle_.store(false, std::memory_order_relaxed);
+        adjustNumberOfThreads();
+    }
+}
+
+
+bool
+ThreadPool::hasWaitingTasks() const noexcept
+{
+    for (std::size_t i = 0; i < NumberOfThreadPoolLanes; ++i) {
+        Queue *queue = &queues_[i];
+        std::size_t position = queue->dequeuePosition.load(std::memory_order_relaxed);
+        Slot *slot = &queue->slots[position & queue->slotIndexMask];
+
+        if (slot->sequenceNumber.load(std::memory_order_acquire) == position + 1) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+bool
+ThreadPool::retireThread() noexcept
+{
+    std::size_t numberOfThreads = numberOfThreads_.load(std::memory_order_relaxed);
+
+    do {
+        if (numberOfThreads <= minNumberOfThreads_) {
+            return false;
+        }
+    } while (!numberOfThreads_.compare_exchange_weak(numberOfThreads, numberOfThreads - 1
+                                                     , std::memory_order_relaxed));
+
+    return true;
+}
+
+
+std::uint64_t
+ThreadPool::getNumberOfDequeuedTasks() const noexcept
+{
+    std::uint64_t numberOfDequeuedTasks = 0;
+
+    for (std::size_t i = 0; i < numberOfWorkers_; ++i) {
+        numberOfDequeuedTasks += workers_[i].numberOfDequeuedTasks.load(std::memory_order_relaxed);
+    }
+
+    return numberOfDequeuedTasks;
+}
+
+
+std::chrono::nanoseconds
+ThreadPool::getTotalQueueLatency() const noexcept
+{
+    std::uint64_t queueLatency = 0;
+
+    for (std::size_t i = 0; i < numberOfWorkers_; ++i) {
+        queueLatency += workers_[i].queueLatency.load(std::memory_order_relaxed);
+    }
+
+    return std::chrono::nanoseconds(queueLatency);
+}
+
+
+void
+ThreadPool::worker(Worker *worker) noexcept
+{
+    CurrentThreadPoolWorker = worker;
+
+    for (;;) {
+        Task *task = removeWaitingTask(worker);
 
         if (task == nullptr) {
+            worker->isAlive.store(false, std::memory_order_release);
             return;
         } else {
-            try {
-                task->procedure_();
-            } catch (...) {
-                task->exception_ = std::current_exception();
+            bool taskIsBulk = !task->isForked_ && task->lane_ == Lane::Bulk;
+            adjustNumberOfThreads();
+            executeTask(task);
+
+            if (taskIsBulk) {
+                numberOfBulkThreads_.fetch_sub(1, std::memory_order_relaxed);
             }
+        }
+    }
+}
 
-            addCompletedTask(task);
-            task->state_.store(TaskState::Completed, std::memory_order_release);
 
-            for (;;) {
-                std::uint64_t dummy = 1;
+void
+ThreadPool::executeTask(Task *task) noexcept
+{
+    Task *previousTask = CurrentThreadPoolTask;
+    CurrentThreadPoolTask = task;
 
-                if (write(eventFD_, &dummy, sizeof(dummy)) < 0) {
-                    if (errno != EINTR) {
-                        std::perror("write() failed");
-                        std::terminate();
-                    }
-                } else {
-                    break;
-                }
+    try {
+        if (task->function_ == nullptr) {
+            task->procedure_();
+        } else {
+            task->function_(task);
+        }
+    } catch (...) {
+        task->exception_ = std::current_exception();
+    }
+
+    CurrentThreadPoolTask = previousTask;
+
+    if (task->isForked_) {
+        task->state_.store(TaskState::Completed, std::memory_order_release);
+        wakeTaskWaiters();
+        return;
+    }
+
+    bool eventIsNeeded = addCompletedTask(task);
+    wakeTaskWaiters();
+
+    if (!eventIsNeeded) {
+        return;
+    }
+
+    for (;;) {
+        std::uint64_t dummy = 1;
+
+        if (write(eventFD_, &dummy, sizeof(dummy)) < 0) {
+            if (errno != EINTR) {
+                std::perror("write() failed");
+                std::terminate();
             }
+        } else {
+            break;
+        }
+    }
+}
+
+
+void
+ThreadPool::setCPUAffinity(const cpu_set_t &cpuAffinity)
+{
+    std::lock_guard<std::mutex> lockGuard(mutex_);
+    cpuAffinity_ = cpuAffinity;
+    hasCPUAffinity_ = true;
+
+    for (std::size_t i = 0; i < numberOfWorkers_; ++i) {
+        if (!workers_[i].isAlive.load(std::memory_order_acquire)) {
+            continue;
+        }
+
+        int errorNumber = pthread_setaffinity_np(threads_[i].native_handle(), sizeof(cpuAffinity_)
+                                                 , &cpuAffinity_);
+
+        if (errorNumber != 0 && errorNumber != ESRCH) {
+            throw std::system_error(errorNumber, std::system_category()
+                                    , "pthread_setaffinity_np() failed");
         }
     }
 }
@@ -149,6 +511,7 @@ ThreadPool::removeTask(Task *task, bool *taskIsCompleted) noexcept
     SIREN_ASSERT(task != nullptr);
     SIREN_ASSERT(taskIsCompleted != nullptr);
     SIREN_ASSERT(task->state_.load(std::memory_order_relaxed) != TaskState::Initial);
+    SIREN_ASSERT(!task->isForked_);
 
     if (task->state_.load(std::memory_order_acquire) == TaskState::Uncompleted) {
         *taskIsCompleted = false;
@@ -159,9 +522,11 @@ ThreadPool::removeTask(Task *task, bool *taskIsCompleted) noexcept
 #endif
             return;
         } else {
-            while (task->state_.load(std::memory_order_acquire) == TaskState::Uncompleted) {
-                std::this_thread::yield();
-            }
+            task->isCancelled_.store(true, std::memory_order_relaxed);
+
+            do {
+                waitForTask(task);
+            } while (task->state_.load(std::memory_order_relaxed) == TaskState::Uncompleted);
         }
     }
 
@@ -170,72 +535,560 @@ ThreadPool::removeTask(Task *task, bool *taskIsCompleted) noexcept
 }
 
 
+bool
+ThreadPool::cancelTask(Task *task) noexcept
+{
+    SIREN_ASSERT(task != nullptr);
+    SIREN_ASSERT(task->state_.load(std::memory_order_relaxed) != TaskState::Initial);
+    SIREN_ASSERT(!task->isForked_);
+
+    if (task->state_.load(std::memory_order_acquire) == TaskState::Uncompleted) {
+        if (removeWaitingTask(task)) {
+#ifdef SIREN_WITH_DEBUG
+            task->state_.store(TaskState::Initial, std::memory_order_relaxed);
+#endif
+            return true;
+        }
+
+        task->isCancelled_.store(true, std::memory_order_relaxed);
+    }
+
+    return false;
+}
+
+
+void
+ThreadPool::joinTask(Task *task)
+{
+    SIREN_ASSERT(task != nullptr);
+    SIREN_ASSERT(task->isForked_);
+    Worker *worker = CurrentThreadPoolWorker;
+    SIREN_ASSERT(worker != nullptr && worker->threadPool == this);
+
+    while (task->state_.load(std::memory_order_acquire) == TaskState::Uncompleted) {
+        Task *otherTask = removeForkedTask(worker);
+
+        if (otherTask == nullptr) {
+            otherTask = stealForkedTask(worker);
+        }
+
+        if (otherTask == nullptr) {
+            waitForTask(task);
+        } else {
+            executeTask(otherTask);
+        }
+    }
+
+    task->check();
+}
+
+
 void
 ThreadPool::addWaitingTask(Task *task)
 {
-    std::lock_guard<std::mutex> lockGuard(mutexes_[0]);
-    waitingTaskList_.appendNode((task->isWaiting_ = true, task));
-    conditionVariable_.notify_one();
+    if (tryAddWaitingTasks(&task, 1, 1) == 0) {
+        throw std::system_error(EAGAIN, std::system_category(), "addTask() failed");
+    }
+}
+
+
+void
+ThreadPool::addWaitingTasks(Task *const *tasks, std::size_t numberOfTasks)
+{
+    if (tryAddWaitingTasks(tasks, numberOfTasks, numberOfTasks) < numberOfTasks) {
+        throw std::system_error(EAGAIN, std::system_category(), "addTasks() failed");
+    }
+}
+
+
+std::size_t
+ThreadPool::tryAddWaitingTasks(Task *const *tasks, std::size_t minNumberOfTasks
+                               , std::size_t maxNumberOfTasks) noexcept
+{
+    if (maxNumberOfTasks == 0) {
+        return 0;
+    }
+
+    Queue *queue = &queues_[static_cast<std::size_t>(tasks[0]->lane_)];
+    std::size_t position;
+    std::size_t numberOfTasks;
+
+    for (;;) {
+        std::size_t dequeuePosition = queue->dequeuePosition.load(std::memory_order_acquire);
+        position = queue->enqueuePosition.load(std::memory_order_relaxed);
+        auto numberOfFreeSlots = static_cast<std::ptrdiff_t>(dequeuePosition + queue->slotIndexMask
+                                                             + 1 - position);
+
+        if (numberOfFreeSlots < static_cast<std::ptrdiff_t>(std::max(minNumberOfTasks
+                                                                     , std::size_t(1)))) {
+            if (queue->dequeuePosition.load(std::memory_order_relaxed) == dequeuePosition) {
+                numberOfTasks = 0;
+                break;
+            }
+
+            continue;
+        }
+
+        numberOfTasks = std::min(maxNumberOfTasks, static_cast<std::size_t>(numberOfFreeSlots));
+
+        if (queue->enqueuePosition.compare_exchange_weak(position, position + numberOfTasks
+                                                         , std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    std::int64_t time = GetTime();
+
+    for (std::size_t i = 0; i < numberOfTasks; ++i, ++position) {
+        Slot *slot = &queue->slots[position & queue->slotIndexMask];
+
+        while (slot->sequenceNumber.load(std::memory_order_acquire) != position) {
+            std::this_thread::yield();
+        }
+
+        tasks[i]->sequenceNumber_ = position;
+        slot->task.store(tasks[i], std::memory_order_relaxed);
+        slot->enqueueTime.store(time, std::memory_order_relaxed);
+        slot->sequenceNumber.store(position + 1, std::memory_order_release);
+    }
+
+#ifdef SIREN_WITH_DEBUG
+    for (std::size_t i = numberOfTasks; i < maxNumberOfTasks; ++i) {
+        tasks[i]->state_.store(TaskState::Initial, std::memory_order_relaxed);
+    }
+#endif
+
+    if (numberOfTasks >= 1) {
+        wakeThreads(numberOfTasks);
+        adjustNumberOfThreads();
+    }
+
+    return numberOfTasks;
 }
 
 
 bool
 ThreadPool::removeWaitingTask(Task *task) noexcept
 {
-    std::unique_lock<std::mutex> uniqueLock(mutexes_[0]);
+    Queue *queue = &queues_[static_cast<std::size_t>(task->lane_)];
+    Slot *slot = &queue->slots[task->sequenceNumber_ & queue->slotIndexMask];
+    return slot->task.compare_exchange_strong(task, nullptr, std::memory_order_relaxed);
+}
+
+
+ThreadPoolTask *
+ThreadPool::removeWaitingTask(Worker *worker) noexcept
+{
+    for (;;) {
+        Task *task = findTask(worker);
+
+        if (task != nullptr) {
+            return task;
+        }
+
+        if (isStopped_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+
+        numberOfSleepingThreads_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        task = findTask(worker);
+
+        if (task == nullptr && !isStopped_.load(std::memory_order_relaxed)) {
+            long timeout = numberOfThreads_.load(std::memory_order_relaxed) > minNumberOfThreads_
+                           ? idleTimeout_.load(std::memory_order_relaxed) : -1;
+
+            if (waitForWakeup(timeout)) {
+                continue;
+            }
+
+            if (!unregisterSleepingThread()) {
+                waitForWakeup(-1);
+                continue;
+            }
+
+            if (retireThread()) {
+                return nullptr;
+            }
+        } else {
+            if (!unregisterSleepingThread()) {
+                waitForWakeup(-1);
+            }
+
+            if (task != nullptr) {
+                return task;
+            }
+        }
+    }
+}
+
+
+ThreadPoolTask *
+ThreadPool::tryRemoveWaitingTask(Worker *worker, Queue *queue) noexcept
+{
+    std::size_t position = queue->dequeuePosition.load(std::memory_order_relaxed);
+
+    for (;;) {
+        Slot *slot = &queue->slots[position & queue->slotIndexMask];
+        std::size_t sequenceNumber = slot->sequenceNumber.load(std::memory_order_acquire);
+        std::ptrdiff_t difference = sequenceNumber - (position + 1);
+
+        if (difference == 0) {
+            if (queue->dequeuePosition.compare_exchange_weak(position, position + 1
+                                                             , std::memory_order_relaxed)) {
+                Task *task = slot->task.exchange(nullptr, std::memory_order_relaxed);
+                std::int64_t enqueueTime = slot->enqueueTime.load(std::memory_order_relaxed);
+                slot->sequenceNumber.store(position + queue->slotIndexMask + 1
+                                           , std::memory_order_release);
+
+                if (task != nullptr) {
+                    worker->numberOfDequeuedTasks.fetch_add(1, std::memory_order_relaxed);
+                    worker->queueLatency.fetch_add(GetTime() - enqueueTime, std::memory_order_relaxed);
+                    return task;
+                }
+
+                position = queue->dequeuePosition.load(std::memory_order_relaxed);
+            }
+        } else if (difference < 0) {
+            return nullptr;
+        } else {
+            position = queue->dequeuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+
+ThreadPoolTask *
+ThreadPool::findTask(Worker *worker) noexcept
+{
+    Task *task = removeForkedTask(worker);
+
+    if (task == nullptr) {
+        task = tryRemoveWaitingTask(worker, &queues_[static_cast<std::size_t>(Lane::Interactive)]);
+
+        if (task == nullptr) {
+            task = tryRemoveBulkTask(worker);
 
-    if (task->isWaiting_) {
-        task->remove();
-        return true;
-    } else {
-        return false;
+            if (task == nullptr) {
+                task = stealForkedTask(worker);
+            }
+        }
     }
+
+    return task;
 }
 
 
 ThreadPoolTask *
-ThreadPool::removeWaitingTask() noexcept
+ThreadPool::tryRemoveBulkTask(Worker *worker) noexcept
 {
-    std::unique_lock<std::mutex> uniqueLock(mutexes_[0]);
+    std::size_t numberOfThreads = numberOfThreads_.load(std::memory_order_relaxed);
+    std::size_t numberOfReservedThreads = numberOfReservedThreads_.load(std::memory_order_relaxed);
+    std::size_t maxNumberOfBulkThreads = numberOfThreads > numberOfReservedThreads
+                                         ? numberOfThreads - numberOfReservedThreads : 1;
+    std::size_t numberOfBulkThreads = numberOfBulkThreads_.load(std::memory_order_relaxed);
+
+    do {
+        if (numberOfBulkThreads >= maxNumberOfBulkThreads) {
+            return nullptr;
+        }
+    } while (!numberOfBulkThreads_.compare_exchange_weak(numberOfBulkThreads
+                                                         , numberOfBulkThreads + 1
+                                                         , std::memory_order_relaxed));
+
+    Task *task = tryRemoveWaitingTask(worker, &queues_[static_cast<std::size_t>(Lane::Bulk)]);
 
-    while (waitingTaskList_.isEmpty()) {
-        conditionVariable_.wait(uniqueLock);
+    if (task == nullptr) {
+        numberOfBulkThreads_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    return task;
+}
+
+
+void
+ThreadPool::addForkedTask(Task *task)
+{
+    Worker *worker = CurrentThreadPoolWorker;
+    SIREN_ASSERT(worker != nullptr && worker->threadPool == this);
+    task->lane_ = Lane::Interactive;
+    std::ptrdiff_t bottom = worker->bottom.load(std::memory_order_relaxed);
+    std::ptrdiff_t top = worker->top.load(std::memory_order_acquire);
+    std::atomic<Task *> *slot = &worker->slots[bottom & worker->slotIndexMask];
+
+    if (std::size_t(bottom - top) > worker->slotIndexMask
+        || slot->load(std::memory_order_relaxed) != nullptr) {
+        executeTask(task);
+        return;
+    }
+
+    task->sequenceNumber_ = bottom;
+    slot->store(task, std::memory_order_relaxed);
+    worker->bottom.store(bottom + 1, std::memory_order_release);
+    wakeThreads(1);
+}
+
+
+ThreadPoolTask *
+ThreadPool::removeForkedTask(Worker *worker) noexcept
+{
+    for (;;) {
+        std::ptrdiff_t bottom = worker->bottom.load(std::memory_order_relaxed) - 1;
+        worker->bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::ptrdiff_t top = worker->top.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            worker->bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        if (top == bottom) {
+            bool taskIsRemoved = worker->top.compare_exchange_strong(top, top + 1
+                                                                     , std::memory_order_seq_cst
+                                                                     , std::memory_order_relaxed);
+            worker->bottom.store(bottom + 1, std::memory_order_relaxed);
+
+            if (!taskIsRemoved) {
+                return nullptr;
+            }
+        }
+
+        Task *task = worker->slots[bottom & worker->slotIndexMask].exchange(nullptr
+                                                                             , std::memory_order_relaxed);
+
+        if (task != nullptr) {
+            return task;
+        }
     }
+}
 
-    ListNode *listNode = waitingTaskList_.getTail();
 
-    if (listNode == &noListNode_) {
+ThreadPoolTask *
+ThreadPool::stealForkedTask(Worker *worker) noexcept
+{
+    if (numberOfWorkers_ < 2) {
         return nullptr;
-    } else {
-        Task *task = static_cast<ThreadPoolTask *>(listNode);
-        (task->isWaiting_ = false, task)->remove();
-        return task;
     }
+
+    worker->randomNumber ^= worker->randomNumber << 13;
+    worker->randomNumber ^= worker->randomNumber >> 17;
+    worker->randomNumber ^= worker->randomNumber << 5;
+    std::size_t i = worker->randomNumber % numberOfWorkers_;
+
+    for (std::size_t n = numberOfWorkers_; n >= 1; --n, i = (i + 1) % numberOfWorkers_) {
+        Worker *victim = &workers_[i];
+
+        if (victim == worker) {
+            continue;
+        }
+
+        std::ptrdiff_t top = victim->top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::ptrdiff_t bottom = victim->bottom.load(std::memory_order_acquire);
+
+        if (top < bottom && victim->top.compare_exchange_strong(top, top + 1
+                                                                , std::memory_order_seq_cst
+                                                                , std::memory_order_relaxed)) {
+            Task *task = victim->slots[top & victim->slotIndexMask].exchange(nullptr
+                                                                             , std::memory_order_acquire);
+
+            if (task != nullptr) {
+                return task;
+            }
+        }
+    }
+
+    return nullptr;
 }
 
 
 void
-ThreadPool::noMoreWaitingTasks()
+ThreadPool::wakeThreads(std::size_t maxNumberOfThreads) noexcept
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int numberOfSleepingThreads = numberOfSleepingThreads_.load(std::memory_order_relaxed);
+
+    while (numberOfSleepingThreads >= 1) {
+        int numberOfThreads = std::min<std::size_t>(numberOfSleepingThreads, maxNumberOfThreads);
+
+        if (numberOfSleepingThreads_.compare_exchange_weak(numberOfSleepingThreads
+                                                           , numberOfSleepingThreads - numberOfThreads
+                                                           , std::memory_order_relaxed)) {
+            wakeupCount_.fetch_add(numberOfThreads, std::memory_order_release);
+            FutexWake(&wakeupCount_, numberOfThreads);
+            return;
+        }
+    }
+}
+
+
+bool
+ThreadPool::waitForWakeup(long timeout) noexcept
+{
+    std::uint32_t wakeupCount = wakeupCount_.load(std::memory_order_acquire);
+
+    for (;;) {
+        if (wakeupCount == 0) {
+            if (!FutexWait(&wakeupCount_, 0, timeout)) {
+                return false;
+            }
+
+            wakeupCount = wakeupCount_.load(std::memory_order_acquire);
+        } else {
+            if (wakeupCount_.compare_exchange_weak(wakeupCount, wakeupCount - 1
+                                                   , std::memory_order_acquire)) {
+                return true;
+            }
+        }
+    }
+}
+
+
+bool
+ThreadPool::unregisterSleepingThread() noexcept
+{
+    int numberOfSleepingThreads = numberOfSleepingThreads_.load(std::memory_order_relaxed);
+
+    do {
+        if (numberOfSleepingThreads == 0) {
+            return false;
+        }
+    } while (!numberOfSleepingThreads_.compare_exchange_weak(numberOfSleepingThreads
+                                                            , numberOfSleepingThreads - 1
+                                                            , std::memory_order_relaxed));
+
+    return true;
+}
+
+
+void
+ThreadPool::wakeTaskWaiters() noexcept
+{
+    taskWakeupCount_.fetch_add(1, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (numberOfTaskWaiters_.load(std::memory_order_relaxed) >= 1) {
+        FutexWake(&taskWakeupCount_, INT_MAX);
+    }
+}
+
+
+void
+ThreadPool::waitForTask(Task *task) noexcept
 {
-    std::lock_guard<std::mutex> lockGuard(mutexes_[0]);
-    waitingTaskList_.prependNode(&noListNode_);
-    conditionVariable_.notify_all();
+    numberOfTaskWaiters_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::uint32_t taskWakeupCount = taskWakeupCount_.load(std::memory_order_acquire);
+
+    if (!task->isForked_) {
+        takeCompletedTasks();
+    }
+
+    if (task->state_.load(std::memory_order_acquire) == TaskState::Uncompleted) {
+        FutexWait(&taskWakeupCount_, taskWakeupCount, -1);
+    }
+
+    numberOfTaskWaiters_.fetch_sub(1, std::memory_order_relaxed);
 }
 
 
 void
-ThreadPool::addCompletedTask(Task *task)
+ThreadPool::noMoreWaitingTasks()
+{
+    isStopped_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wakeupCount_.fetch_add(UINT32_C(1) << 30, std::memory_order_release);
+    FutexWake(&wakeupCount_, INT_MAX);
+    monitorWakeupCount_.fetch_add(1, std::memory_order_release);
+    FutexWake(&monitorWakeupCount_, 1);
+}
+
+
+bool
+ThreadPool::addCompletedTask(Task *task) noexcept
 {
-    std::unique_lock<std::mutex> uniqueLock(mutexes_[1]);
-    completedTaskList_.appendNode(task);
+    Task *nextTask = completedTaskStack_.load(std::memory_order_relaxed);
+
+    do {
+        task->nextCompletedTask_ = nextTask;
+    } while (!completedTaskStack_.compare_exchange_weak(nextTask, task, std::memory_order_release
+                                                        , std::memory_order_relaxed));
+
+    return nextTask == nullptr;
 }
 
 
 void
 ThreadPool::removeCompletedTask(Task *task) noexcept
 {
-    std::unique_lock<std::mutex> uniqueLock(mutexes_[1]);
+    takeCompletedTasks();
     task->remove();
 }
 
+
+void
+ThreadPool::takeCompletedTasks() noexcept
+{
+    Task *task = completedTaskStack_.exchange(nullptr, std::memory_order_acquire);
+    List list;
+
+    for (; task != nullptr; task = task->nextCompletedTask_) {
+        task->state_.store(TaskState::Completed, std::memory_order_relaxed);
+        list.prependNode(task);
+    }
+
+    list.append(&completedTaskList_);
+}
+
+
+
+namespace {
+
+std::int64_t
+GetTime() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()
+                                                                .time_since_epoch()).count();
+}
+
+
+bool
+FutexWait(std::atomic<std::uint32_t> *word, std::uint32_t value, long timeout) noexcept
+{
+    timespec time;
+
+    if (timeout >= 0) {
+        time.tv_sec = timeout / 1000;
+        time.tv_nsec = timeout % 1000 * 1000000;
+    }
+
+    if (syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(word), FUTEX_WAIT_PRIVATE, value
+                , timeout >= 0 ? &time : nullptr, nullptr, 0) < 0) {
+        if (errno == ETIMEDOUT) {
+            return false;
+        }
+
+        if (errno != EAGAIN && errno != EINTR) {
+            std::perror("futex() failed");
+            std::terminate();
+        }
+    }
+
+    return true;
+}
+
+
+void
+FutexWake(std::atomic<std::uint32_t> *word, int numberOfThreads) noexcept
+{
+    if (syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(word), FUTEX_WAKE_PRIVATE
+                , numberOfThreads, nullptr, nullptr, 0) < 0) {
+        std::perror("futex() failed");
+        std::terminate();
+    }
+}
+
+} // namespace
+
 } // namespace siren
@@ -0,0 +1,313 @@
+#include "udp_socket.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <algorithm>
+#include <exception>
+#include <system_error>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "assert.h"
+#include "loop.h"
+
+
+namespace siren {
+
+UDPSocket::UDPSocket(Loop *loop)
+  : loop_(loop)
+{
+    SIREN_ASSERT(loop != nullptr);
+    initialize();
+}
+
+
+UDPSocket::UDPSocket(UDPSocket &&other) noexcept
+  : loop_(other.loop_)
+{
+    other.move(this);
+}
+
+
+UDPSocket::~UDPSocket()
+{
+    if (isValid()) {
+        finalize();
+    }
+}
+
+
+UDPSocket &
+UDPSocket::operator=(UDPSocket &&other) noexcept
+{
+    if (&other != this) {
+        finalize();
+        loop_ = other.loop_;
+        other.move(this);
+    }
+
+    return *this;
+}
+
+
+void
+UDPSocket::initialize()
+{
+    fd_ = loop_->socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (fd_ < 0) {
+        throw std::system_error(errno, std::system_category(), "socket() failed");
+    }
+}
+
+
+void
+UDPSocket::finalize() noexcept
+{
+    if (loop_->close(fd_) < 0 && errno != EINTR) {
+        std::perror("close() failed");
+        std::terminate();
+    }
+}
+
+
+void
+UDPSocket::move(UDPSocket *other) noexcept
+{
+    other->fd_ = fd_;
+    fd_ = -1;
+}
+
+
+void
+UDPSocket::setReuseAddress(bool reuseAddress)
+{
+    int onOff = reuseAddress;
+
+    if (setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &onOff, sizeof(onOff)) < 0) {
+        throw std::system_error(errno, std::system_category(), "setsockopt(SO_REUSEADDR) failed");
+    }
+}
+
+
+void
+UDPSocket::setReceiveTimeout(long receiveTimeout)
+{
+    SIREN_ASSERT(receiveTimeout >= 0);
+    timeval time;
+    time.tv_sec = receiveTimeout / 1000;
+    time.tv_usec = (receiveTimeout % 1000) * 1000;
+
+    if (loop_->setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &time, sizeof(time)) < 0) {
+        throw std::system_error(errno, std::system_category(), "setsockopt(SO_RCVTIMEO) failed");
+    }
+}
+
+
+void
+UDPSocket::setSendTimeout(long sendTimeout)
+{
+    SIREN_ASSERT(sendTimeout >= 0);
+    timeval time;
+    time.tv_sec = sendTimeout / 1000;
+    time.tv_usec = (sendTimeout % 1000) * 1000;
+
+    if (loop_->setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &time, sizeof(time)) < 0) {
+        throw std::system_error(errno, std::system_category(), "setsockopt(SO_SNDTIMEO) failed");
+    }
+}
+
+
+void
+UDPSocket::setReceiveBufferSize(int receiveBufferSize)
+{
+    if (setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof(receiveBufferSize)) < 0) {
+        throw std::system_error(errno, std::system_category(), "setsockopt(SO_RCVBUF) failed");
+    }
+}
+
+
+void
+UDPSocket::setSendBufferSize(int sendBufferSize)
+{
+    if (setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &sendBufferSize, sizeof(sendBufferSize)) < 0) {
+        throw std::system_error(errno, std::system_category(), "setsockopt(SO_SNDBUF) failed");
+    }
+}
+
+
+void
+UDPSocket::bind(const IPEndpoint &ipEndpoint)
+{
+    SIREN_ASSERT(isValid());
+    sockaddr_in name;
+    name.sin_family = AF_INET;
+    name.sin_addr.s_addr = htonl(ipEndpoint.address);
+    name.sin_port = htons(ipEndpoint.portNumber);
+
+    if (::bind(fd_, reinterpret_cast<sockaddr *>(&name), sizeof(name)) < 0) {
+        throw std::system_error(errno, std::system_category(), "bind() failed");
+    }
+}
+
+
+void
+UDPSocket::connect(const IPEndpoint &ipEndpoint)
+{
+    SIREN_ASSERT(isValid());
+    sockaddr_in name;
+    name.sin_family = AF_INET;
+    name.sin_addr.s_addr = htonl(ipEndpoint.address);
+    name.sin_port = htons(ipEndpoint.portNumber);
+
+    if (loop_->connect(fd_, reinterpret_cast<sockaddr *>(&name), sizeof(name)) < 0) {
+        throw std::system_error(errno, std::system_category(), "connect() failed");
+    }
+}
+
+
+IPEndpoint
+UDPSocket::getLocalEndpoint() const
+{
+    SIREN_ASSERT(isValid());
+    sockaddr_in name;
+    socklen_t nameSize = sizeof(name);
+
+    if (getsockname(fd_, reinterpret_cast<sockaddr *>(&name), &nameSize) < 0) {
+        throw std::system_error(errno, std::system_category(), "getsockname() failed");
+    }
+
+    return IPEndpoint(name);
+}
+
+
+IPEndpoint
+UDPSocket::getRemoteEndpoint() const
+{
+    SIREN_ASSERT(isValid());
+    sockaddr_in name;
+    socklen_t nameSize = sizeof(name);
+
+    if (getpeername(fd_, reinterpret_cast<sockaddr *>(&name), &nameSize) < 0) {
+        throw std::system_error(errno, std::system_category(), "getpeername() failed");
+    }
+
+    return IPEndpoint(name);
+}
+
+
+std::size_t
+UDPSocket::receiveFrom(void *buffer, std::size_t bufferSize, IPEndpoint *ipEndpoint)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(buffer != nullptr || bufferSize == 0);
+    sockaddr_in name;
+    socklen_t nameSize = sizeof(name);
+    ssize_t numberOfBytes = loop_->recvfrom(fd_, buffer, bufferSize, 0
+                                            , reinterpret_cast<sockaddr *>(&name), &nameSize);
+
+    if (numberOfBytes < 0) {
+        throw std::system_error(errno, std::system_category(), "recvfrom() failed");
+    }
+
+    if (ipEndpoint != nullptr) {
+        *ipEndpoint = IPEndpoint(name);
+    }
+
+    return numberOfBytes;
+}
+
+
+std::size_t
+UDPSocket::sendTo(const void *data, std::size_t dataSize, const IPEndpoint &ipEndpoint)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(data != nullptr || dataSize == 0);
+    sockaddr_in name;
+    name.sin_family = AF_INET;
+    name.sin_addr.s_addr = htonl(ipEndpoint.address);
+    name.sin_port = htons(ipEndpoint.portNumber);
+    ssize_t numberOfBytes = loop_->sendto(fd_, data, dataSize, 0
+                                          , reinterpret_cast<sockaddr *>(&name), sizeof(name));
+
+    if (numberOfBytes < 0) {
+        throw std::system_error(errno, std::system_category(), "sendto() failed");
+    }
+
+    return numberOfBytes;
+}
+
+
+std::size_t
+UDPSocket::receiveMany(UDPDatagram *datagrams, std::size_t numberOfDatagrams)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(datagrams != nullptr || numberOfDatagrams == 0);
+    mmsghdr messages[64];
+    iovec vectors[64];
+    sockaddr_in names[64];
+    numberOfDatagrams = std::min(numberOfDatagrams, sizeof(messages) / sizeof(*messages));
+
+    for (std::size_t i = 0; i < numberOfDatagrams; ++i) {
+        vectors[i].iov_base = datagrams[i].data;
+        vectors[i].iov_len = datagrams[i].dataSize;
+        messages[i].msg_hdr.msg_name = &names[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(names[i]);
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_control = nullptr;
+        messages[i].msg_hdr.msg_controllen = 0;
+        messages[i].msg_hdr.msg_flags = 0;
+    }
+
+    int numberOfMessages = loop_->recvmmsg(fd_, messages, numberOfDatagrams, 0, nullptr);
+
+    if (numberOfMessages < 0) {
+        throw std::system_error(errno, std::system_category(), "recvmmsg() failed");
+    }
+
+    for (int i = 0; i < numberOfMessages; ++i) {
+        datagrams[i].dataSize = messages[i].msg_len;
+        datagrams[i].endpoint = IPEndpoint(names[i]);
+    }
+
+    return numberOfMessages;
+}
+
+
+std::size_t
+UDPSocket::sendMany(const UDPDatagram *datagrams, std::size_t numberOfDatagrams)
+{
+    SIREN_ASSERT(isValid());
+    SIREN_ASSERT(datagrams != nullptr || numberOfDatagrams == 0);
+    mmsghdr messages[64];
+    iovec vectors[64];
+    sockaddr_in names[64];
+    numberOfDatagrams = std::min(numberOfDatagrams, sizeof(messages) / sizeof(*messages));
+
+    for (std::size_t i = 0; i < numberOfDatagrams; ++i) {
+        vectors[i].iov_base = datagrams[i].data;
+        vectors[i].iov_len = datagrams[i].dataSize;
+        names[i].sin_family = AF_INET;
+        names[i].sin_addr.s_addr = htonl(datagrams[i].endpoint.address);
+        names[i].sin_port = htons(datagrams[i].endpoint.portNumber);
+        messages[i].msg_hdr.msg_name = &names[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(names[i]);
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_control = nullptr;
+        messages[i].msg_hdr.msg_controllen = 0;
+        messages[i].msg_hdr.msg_flags = 0;
+    }
+
+    int numberOfMessages = loop_->sendmmsg(fd_, messages, numberOfDatagrams, 0);
+
+    if (numberOfMessages < 0) {
+        throw std::system_error(errno, std::system_category(), "sendmmsg() failed");
+    }
+
+    return numberOfMessages;
+}
+
+} // namespace siren
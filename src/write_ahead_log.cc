@@ -0,0 +1,380 @@
+#include "write_ahead_log.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <algorithm>
+#include <exception>
+#include <system_error>
+#include <utility>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "archive.h"
+#include "assert.h"
+#include "async.h"
+#include "loop.h"
+#include "scope_guard.h"
+
+
+namespace siren {
+
+namespace detail {
+
+struct WriteAheadLogGroup
+{
+    Event event;
+    std::exception_ptr exception;
+};
+
+} // namespace detail
+
+
+namespace {
+
+std::uint32_t HashBytes(const void *, std::size_t) noexcept;
+void SyncDirectory(const std::string &);
+
+} // namespace
+
+
+WriteAheadLog::WriteAheadLog(Loop *loop, Async *async, const std::string &directoryName
+                             , std::size_t maxBatchSize, std::chrono::microseconds maxBatchDelay
+                             , std::size_t maxSegmentSize)
+  : loop_(loop),
+    async_(async),
+    directoryName_(directoryName),
+    maxBatchSize_(maxBatchSize),
+    maxBatchDelay_(maxBatchDelay),
+    maxSegmentSize_(maxSegmentSize),
+    pendingGroup_(new Group{loop->makeEvent(), nullptr}),
+    writerEvent_(loop->makeEvent()),
+    writerExitEvent_(loop->makeEvent()),
+    segmentFD_(-1),
+    segmentSize_(0)
+{
+    SIREN_ASSERT(loop != nullptr);
+    SIREN_ASSERT(async != nullptr);
+    writerFiberHandle_ = loop_->createFiber([this] () -> void { writeRecords(); }, 0, true);
+}
+
+
+WriteAheadLog::~WriteAheadLog()
+{
+    SIREN_ASSERT(pendingData_.getDataSize() == 0);
+    loop_->interruptFiber(writerFiberHandle_);
+    bool fiberIsInterrupted = false;
+
+    for (;;) {
+        try {
+            writerExitEvent_.waitFor();
+            break;
+        } catch (FiberInterruption) {
+            fiberIsInterrupted = true;
+        }
+    }
+
+    if (fiberIsInterrupted) {
+        loop_->interruptFiber(loop_->getCurrentFiber());
+    }
+
+    closeSegment();
+}
+
+
+void
+WriteAheadLog::append(const void *record, std::size_t recordSize)
+{
+    SIREN_ASSERT(record != nullptr || recordSize == 0);
+    Archive archive(&pendingData_);
+    archive << VLI<std::size_t>(recordSize) << HashBytes(record, recordSize);
+    archive.serializeBytes(record, recordSize);
+    pendingData_.commitBuffer(archive.getNumberOfPreWrittenBytes());
+    std::shared_ptr<Group> group = pendingGroup_;
+    writerEvent_.trigger();
+    group->event.waitFor();
+
+    if (group->exception != nullptr) {
+        std::rethrow_exception(group->exception);
+    }
+}
+
+
+void
+WriteAheadLog::replay(const std::function<void (const void *, std::size_t)> &callback)
+{
+    SIREN_ASSERT(segmentFD_ < 0);
+    SIREN_ASSERT(callback != nullptr);
+    std::vector<std::uint64_t> segmentNumbers = async_->callFunction(ListSegmentNumbers
+                                                                     , directoryName_);
+
+    for (std::uint64_t segmentNumber : segmentNumbers) {
+        std::string fileName = MakeSegmentFileName(directoryName_, segmentNumber);
+        int fd = async_->callFunction(open, fileName.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (fd < 0) {
+            throw std::system_error(errno, std::system_category(), "open() failed");
+        }
+
+        auto scopeGuard = MakeScopeGuard([&] () -> void {
+            if (close(fd) < 0 && errno != EINTR) {
+                std::perror("close() failed");
+                std::terminate();
+            }
+        });
+
+        Stream stream;
+
+        for (;;) {
+            stream.reserveBuffer(64 * 1024);
+            ssize_t numberOfBytes = async_->read(fd, stream.getBuffer(), stream.getBufferSize());
+
+            if (numberOfBytes < 0) {
+                throw std::system_error(errno, std::system_category(), "read() failed");
+            }
+
+            if (numberOfBytes == 0) {
+                break;
+            }
+
+            stream.commitBuffer(numberOfBytes);
+        }
+
+        for (;;) {
+            Archive archive(&stream);
+            VLI<std::size_t> recordSize;
+            std::uint32_t checksum;
+
+            try {
+                archive >> recordSize >> checksum;
+            } catch (const EndOfStream &) {
+                break;
+            }
+
+            std::size_t headerSize = archive.getNumberOfPreReadBytes();
+
+            if (stream.getDataSize() - headerSize < recordSize) {
+                break;
+            }
+
+            const void *record = stream.getData(headerSize);
+
+            if (HashBytes(record, recordSize) != checksum) {
+                break;
+            }
+
+            callback(record, recordSize);
+            stream.discardData(headerSize + recordSize);
+        }
+    }
+}
+
+
+void
+WriteAheadLog::writeRecords() noexcept
+{
+    auto scopeGuard = MakeScopeGuard([&] () -> void {
+        writerExitEvent_.trigger();
+    });
+
+    try {
+        for (;;) {
+            writerEvent_.waitFor();
+            writerEvent_.reset();
+
+            if (maxBatchDelay_.count() >= 1 && pendingData_.getDataSize() < maxBatchSize_) {
+                loop_->usleep(maxBatchDelay_.count());
+            }
+
+            if (pendingData_.getDataSize() == 0) {
+                continue;
+            }
+
+            Stream data = std::move(pendingData_);
+            std::shared_ptr<Group> group = std::move(pendingGroup_);
+            pendingGroup_.reset(new Group{loop_->makeEvent(), nullptr});
+
+            try {
+                flushRecords(&data);
+            } catch (FiberInterruption) {
+                throw;
+            } catch (...) {
+                group->exception = std::current_exception();
+                closeSegment();
+            }
+
+            group->event.trigger();
+        }
+    } catch (FiberInterruption) {
+        return;
+    }
+}
+
+
+void
+WriteAheadLog::flushRecords(Stream *data)
+{
+    if (segmentFD_ < 0) {
+        openSegment();
+    }
+
+    std::size_t dataSize = data->getDataSize();
+
+    try {
+        while (data->getDataSize() >= 1) {
+            ssize_t numberOfBytes = async_->write(segmentFD_, data->getData()
+                                                  , data->getDataSize());
+
+            if (numberOfBytes < 0) {
+                throw std::system_error(errno, std::system_category(), "write() failed");
+            }
+
+            data->discardData(numberOfBytes);
+        }
+
+        if (async_->fdatasync(segmentFD_) < 0) {
+            throw std::system_error(errno, std::system_category(), "fdatasync() failed");
+        }
+    } catch (FiberInterruption) {
+        throw;
+    } catch (...) {
+        // Cut the failed batch off again, so that replay() won't return records append() has
+        // reported as not logged.
+        std::exception_ptr exception = std::current_exception();
+        async_->callFunction(ftruncate, segmentFD_, static_cast<off_t>(segmentSize_));
+        std::rethrow_exception(std::move(exception));
+    }
+
+    segmentSize_ += dataSize;
+
+    if (segmentSize_ >= maxSegmentSize_) {
+        closeSegment();
+    }
+}
+
+
+void
+WriteAheadLog::openSegment()
+{
+    std::vector<std::uint64_t> segmentNumbers = async_->callFunction(ListSegmentNumbers
+                                                                     , directoryName_);
+    std::uint64_t segmentNumber = segmentNumbers.empty() ? 0 : segmentNumbers.back() + 1;
+    std::string fileName = MakeSegmentFileName(directoryName_, segmentNumber);
+    int fd = async_->callFunction(open, fileName.c_str()
+                                  , O_WRONLY | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0644);
+
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "open() failed");
+    }
+
+    segmentFD_ = fd;
+    segmentSize_ = 0;
+    async_->callFunction(SyncDirectory, directoryName_);
+}
+
+
+void
+WriteAheadLog::closeSegment() noexcept
+{
+    if (segmentFD_ >= 0) {
+        if (close(segmentFD_) < 0 && errno != EINTR) {
+            std::perror("close() failed");
+            std::terminate();
+        }
+
+        segmentFD_ = -1;
+    }
+}
+
+
+std::vector<std::uint64_t>
+WriteAheadLog::ListSegmentNumbers(const std::string &directoryName)
+{
+    DIR *directory = opendir(directoryName.c_str());
+
+    if (directory == nullptr) {
+        throw std::system_error(errno, std::system_category(), "opendir() failed");
+    }
+
+    auto scopeGuard = MakeScopeGuard([&] () -> void {
+        closedir(directory);
+    });
+
+    std::vector<std::uint64_t> segmentNumbers;
+
+    for (;;) {
+        errno = 0;
+        dirent *entry = readdir(directory);
+
+        if (entry == nullptr) {
+            if (errno != 0) {
+                throw std::system_error(errno, std::system_category(), "readdir() failed");
+            }
+
+            break;
+        }
+
+        std::uint64_t segmentNumber;
+
+        if (std::sscanf(entry->d_name, "%20" SCNu64, &segmentNumber) == 1
+            && MakeSegmentFileName(directoryName, segmentNumber)
+               == directoryName + "/" + entry->d_name) {
+            segmentNumbers.push_back(segmentNumber);
+        }
+    }
+
+    std::sort(segmentNumbers.begin(), segmentNumbers.end());
+    return segmentNumbers;
+}
+
+
+std::string
+WriteAheadLog::MakeSegmentFileName(const std::string &directoryName, std::uint64_t segmentNumber)
+{
+    char baseName[32];
+    std::snprintf(baseName, sizeof(baseName), "%020" PRIu64 ".wal", segmentNumber);
+    return directoryName + "/" + baseName;
+}
+
+
+namespace {
+
+std::uint32_t
+HashBytes(const void *bytes, std::size_t numberOfBytes) noexcept
+{
+    std::uint32_t hash = 2166136261;
+
+    for (std::size_t i = 0; i < numberOfBytes; ++i) {
+        hash = (hash ^ static_cast<const unsigned char *>(bytes)[i]) * 16777619;
+    }
+
+    return hash;
+}
+
+
+void
+SyncDirectory(const std::string &directoryName)
+{
+    int fd = open(directoryName.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "open() failed");
+    }
+
+    auto scopeGuard = MakeScopeGuard([&] () -> void {
+        if (close(fd) < 0 && errno != EINTR) {
+            std::perror("close() failed");
+            std::terminate();
+        }
+    });
+
+    if (fsync(fd) < 0) {
+        throw std::system_error(errno, std::system_category(), "fsync() failed");
+    }
+}
+
+} // namespace
+
+} // namespace siren
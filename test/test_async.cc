@@ -1,5 +1,13 @@
+#include <atomic>
 #include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <functional>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "async.h"
 #include "loop.h"
@@ -13,7 +21,7 @@ using namespace siren;
 
 SIREN_TEST("Execute async task")
 {
-    Loop loop;
+    Loop loop(64 * 1024);
     Async async(&loop, 1);
 
     loop.createFiber([&] () {
@@ -55,10 +63,11 @@ SIREN_TEST("Execute async task")
 
     loop.createFiber([&] () {
         loop.interruptFiber(f);
-        SIREN_TEST_ASSERT(x == 1 || x == 2);
+        SIREN_TEST_ASSERT(x == 0 || x == 2);
     });
 
     loop.run();
+    SIREN_TEST_ASSERT(x == 2);
 }
 
 }
@@ -66,7 +75,7 @@ SIREN_TEST("Execute async task")
 
 SIREN_TEST("Do async calls")
 {
-    Loop loop;
+    Loop loop(64 * 1024);
     Async async(&loop, 1);
 
     loop.createFiber([&] () {
@@ -87,3 +96,301 @@ SIREN_TEST("Do async calls")
 
     loop.run();
 }
+
+
+SIREN_TEST("Read/Write cached file without offloading")
+{
+    Loop loop(64 * 1024);
+    Async async(&loop, 1);
+
+    loop.createFiber([&] () {
+        std::FILE *f = std::tmpfile();
+        int fd = fileno(f);
+        SIREN_TEST_ASSERT(async.write(fd, "hello", 5) == 5);
+        SIREN_TEST_ASSERT(lseek(fd, 0, SEEK_SET) == 0);
+        char s[5];
+        SIREN_TEST_ASSERT(async.read(fd, s, 5) == 5);
+        SIREN_TEST_ASSERT(std::memcmp(s, "hello", 5) == 0);
+        SIREN_TEST_ASSERT(async.read(fd, s, 5) == 0);
+        SIREN_TEST_ASSERT(async.getNumberOfNoWaitHits() + async.getNumberOfNoWaitMisses() == 3);
+        SIREN_TEST_ASSERT(async.getNumberOfNoWaitHits() >= 2);
+        std::fclose(f);
+    });
+
+    loop.run();
+}
+
+
+SIREN_TEST("Read cached file up to end without offloading")
+{
+    Loop loop(64 * 1024);
+    Async async(&loop, 1);
+
+    loop.createFiber([&] () {
+        std::FILE *f = std::tmpfile();
+        int fd = fileno(f);
+        SIREN_TEST_ASSERT(async.write(fd, "hello", 5) == 5);
+        std::uint64_t n = async.getNumberOfNoWaitMisses();
+        char s[100];
+        SIREN_TEST_ASSERT(async.pread(fd, s, sizeof(s), 0) == 5);
+        SIREN_TEST_ASSERT(std::memcmp(s, "hello", 5) == 0);
+        SIREN_TEST_ASSERT(async.getNumberOfNoWaitMisses() == n);
+        std::fclose(f);
+    });
+
+    loop.run();
+}
+
+
+SIREN_TEST("Read partly cached file")
+{
+    Loop loop(64 * 1024);
+    Async async(&loop, 1);
+
+    loop.createFiber([&] () -> void {
+        std::FILE *f = std::tmpfile();
+        int fd = fileno(f);
+        std::vector<char> s(1024 * 1024, 'x');
+        SIREN_TEST_ASSERT(async.write(fd, s.data(), s.size()) == ssize_t(s.size()));
+        SIREN_TEST_ASSERT(async.fsync(fd) == 0);
+        posix_fadvise(fd, s.size() / 2, 0, POSIX_FADV_DONTNEED);
+        std::vector<char> t(s.size());
+        std::size_t i = 0;
+
+        while (i < t.size()) {
+            ssize_t n = async.pread(fd, t.data() + i, t.size() - i, i);
+            SIREN_TEST_ASSERT(n >= 1);
+            i += n;
+        }
+
+        SIREN_TEST_ASSERT(t == s);
+        std::fclose(f);
+    });
+
+    loop.run();
+}
+
+
+SIREN_TEST("Read one file from many fibers with positional I/O")
+{
+    Loop loop(64 * 1024);
+    Async async(&loop, 4);
+    std::FILE *f = std::tmpfile();
+    int fd = fileno(f);
+
+    loop.createFiber([&] () {
+        char s[4096];
+
+        for (int i = 0; i < 16; ++i) {
+            std::memset(s, 'a' + i, sizeof(s));
+            SIREN_TEST_ASSERT(async.pwrite(fd, s, sizeof(s), i * sizeof(s)) == sizeof(s));
+        }
+
+        SIREN_TEST_ASSERT(async.fdatasync(fd) == 0);
+
+        for (int i = 0; i < 16; ++i) {
+            loop.createFiber([&, i] () {
+                char s[4096];
+                iovec v[2] = {{s, 1024}, {s + 1024, sizeof(s) - 1024}};
+                SIREN_TEST_ASSERT(async.preadv(fd, v, 2, i * sizeof(s)) == sizeof(s));
+                SIREN_TEST_ASSERT(s[0] == 'a' + i && s[sizeof(s) - 1] == 'a' + i);
+            });
+        }
+    });
+
+    loop.run();
+    std::fclose(f);
+}
+
+
+SIREN_TEST("Execute async tasks in batch")
+{
+    Loop loop(64 * 1024);
+    Async async(&loop, 4);
+
+    loop.createFiber([&] () {
+        int a[8] = {};
+        std::vector<std::function<void ()>> ps;
+
+        for (int i = 0; i < 8; ++i) {
+            ps.push_back([&a, i] () {
+                usleep(20 * 1000);
+                a[i] = i + 1;
+
+                if (i % 2 == 1) {
+                    throw i;
+                }
+            });
+        }
+
+        std::vector<std::exception_ptr> es = async.executeTasks(ps);
+        SIREN_TEST_ASSERT(es.size() == 8);
+
+        for (int i = 0; i < 8; ++i) {
+            SIREN_TEST_ASSERT(a[i] == i + 1);
+
+            if (i % 2 == 1) {
+                try {
+                    std::rethrow_exception(es[i]);
+                } catch (int j) {
+                    SIREN_TEST_ASSERT(j == i);
+                }
+            } else {
+                SIREN_TEST_ASSERT(es[i] == nullptr);
+            }
+        }
+
+        std::size_t i = async.executeAnyTask({
+            [] () {
+                usleep(100 * 1000);
+            },
+            [] () {
+            },
+        });
+
+        SIREN_TEST_ASSERT(i == 1);
+    });
+
+    loop.run();
+}
+
+
+SIREN_TEST("Execute async tasks beyond queue capacity")
+{
+    Loop loop(64 * 1024);
+    Async async(&loop, 2);
+    std::atomic<int> n(0);
+
+    for (int i = 0; i < 2; ++i) {
+        loop.createFiber([&] () {
+            std::vector<std::function<void ()>> ps(20000, [&n] () {
+                n.fetch_add(1, std::memory_order_relaxed);
+            });
+
+            std::vector<std::exception_ptr> es = async.executeTasks(ps);
+            SIREN_TEST_ASSERT(es.size() == 20000);
+        });
+    }
+
+    loop.run();
+    SIREN_TEST_ASSERT(n.load(std::memory_order_relaxed) == 40000);
+}
+
+
+SIREN_TEST("Cancel running async task without stalling loop")
+{
+    Loop loop(64 * 1024);
+    Async async(&loop, 1);
+    std::atomic<int> x(0);
+    int y = 0;
+
+    void *f = loop.createFiber([&] () {
+        try {
+            async.executeTask([&] () {
+                while (!ThreadPool::CurrentTaskIsCancelled()) {
+                    usleep(1000);
+                }
+
+                x = 1;
+                usleep(100 * 1000);
+                x = 2;
+            });
+
+            loop.usleep(1000);
+        } catch (FiberInterruption) {
+            y = 1;
+        }
+    });
+
+    loop.createFiber([&] () {
+        loop.usleep(20 * 1000);
+        loop.interruptFiber(f);
+        loop.usleep(20 * 1000);
+        SIREN_TEST_ASSERT(x == 1);
+    });
+
+    loop.run();
+    SIREN_TEST_ASSERT(x == 2);
+    SIREN_TEST_ASSERT(y == 1);
+    SIREN_TEST_ASSERT(!ThreadPool::CurrentTaskIsCancelled());
+}
+
+
+SIREN_TEST("Run parallel for and parallel reduce from fiber")
+{
+    Loop loop(64 * 1024);
+    Async async(&loop, 4);
+    int y = 0;
+
+    loop.createFiber([&] () {
+        std::vector<int> a(1000);
+
+        async.parallelFor(0, a.size(), 64, [&] (std::size_t i) {
+            a[i] = i + 1;
+        });
+
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            SIREN_TEST_ASSERT(a[i] == int(i + 1));
+        }
+
+        long s = async.parallelReduce(0, a.size(), 100, 0L, [&] (std::size_t i) {
+            return long(a[i]);
+        }, [] (long v1, long v2) {
+            return v1 + v2;
+        });
+
+        SIREN_TEST_ASSERT(s == 1000L * 1001 / 2);
+        SIREN_TEST_ASSERT(async.parallelReduce(5, 5, 1, 7, [] (std::size_t) {
+            return 1;
+        }, [] (int v1, int v2) {
+            return v1 + v2;
+        }) == 7);
+
+        try {
+            async.parallelFor(0, 100, 10, [] (std::size_t i) {
+                if (i == 55 || i == 85) {
+                    throw int(i);
+                }
+            });
+        } catch (int i) {
+            y = i;
+        }
+    });
+
+    loop.run();
+    SIREN_TEST_ASSERT(y == 55);
+}
+
+
+SIREN_TEST("Interrupt parallel reduce from fiber")
+{
+    Loop loop(64 * 1024);
+    Async async(&loop, 2);
+    std::atomic<int> n(0);
+    long s = -1;
+    int y = 0;
+
+    void *f = loop.createFiber([&] () {
+        try {
+            s = async.parallelReduce(0, 1000, 10, 0L, [&] (std::size_t i) {
+                usleep(1000);
+                ++n;
+                return long(i);
+            }, [] (long v1, long v2) {
+                return v1 + v2;
+            });
+        } catch (FiberInterruption) {
+            y = 1;
+        }
+    });
+
+    loop.createFiber([&] () {
+        loop.usleep(20 * 1000);
+        loop.interruptFiber(f);
+    });
+
+    loop.run();
+    SIREN_TEST_ASSERT(y == 1);
+    SIREN_TEST_ASSERT(s == -1);
+    SIREN_TEST_ASSERT(n < 1000);
+}
@@ -24,6 +24,10 @@ SIREN_TEST("Add/Remove io timers")
         ioClock.addTimer(&dummies[i], std::chrono::milliseconds(5 * i));
     }
 
+    SIREN_TEST_ASSERT(ioClock.getDueTime() == std::chrono::milliseconds(0));
+    ioClock.removeTimer(&dummies[0]);
+    ioClock.addTimer(&dummies[0], std::chrono::microseconds(300));
+    SIREN_TEST_ASSERT(ioClock.getDueTime() == std::chrono::microseconds(300));
     ioClock.removeTimer(&dummies[8]);
     ioClock.removeTimer(&dummies[17]);
 
@@ -44,4 +48,31 @@ SIREN_TEST("Add/Remove io timers")
     }
 }
 
+
+
+SIREN_TEST("Coalesce io timers with slack")
+{
+    struct Dummy : IOTimer {
+    };
+
+    IOClock ioClock;
+    Dummy dummies[2];
+    ioClock.addTimer(&dummies[0], std::chrono::milliseconds(10));
+    ioClock.addTimer(&dummies[1], std::chrono::milliseconds(5), std::chrono::milliseconds(200));
+    SIREN_TEST_ASSERT(ioClock.getDueTime() == std::chrono::milliseconds(10));
+    std::vector<IOTimer *> timers;
+
+    while (timers.size() < 2) {
+        ioClock.start();
+        usleep(11 * 1000);
+        ioClock.stop();
+
+        ioClock.removeExpiredTimers([&] (IOTimer *x) -> void {
+            timers.push_back(x);
+        });
+    }
+
+    SIREN_TEST_ASSERT(ioClock.getNumberOfSavedWakeups() == 1);
+}
+
 }
@@ -11,7 +11,7 @@ using namespace siren;
 
 SIREN_TEST("Make ip endpoints")
 {
-    Loop l;
+    Loop l(64 * 1024);
     Async a(&l, 1);
 
     l.createFiber([&] () -> void {
@@ -1,7 +1,12 @@
+#include <cerrno>
 #include <cstdlib>
 #include <cstring>
+#include <chrono>
 
 #include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
 #include "loop.h"
@@ -39,4 +44,286 @@ SIREN_TEST("Read/Write loop pipe")
     std::free(dummy);
 }
 
+
+
+SIREN_TEST("Fail blocked loop pipe write when reader closes")
+{
+    int fds[2];
+    Loop loop(16 * 1024);
+    loop.pipe(fds);
+    char data[1024] = {};
+
+    while (::write(fds[1], data, sizeof(data)) >= 1) {
+    }
+
+    struct sigaction sa = {}, osa;
+    sa.sa_handler = SIG_IGN;
+    SIREN_TEST_ASSERT(sigaction(SIGPIPE, &sa, &osa) == 0);
+    int e = 0;
+
+    loop.createFiber([&] () -> void {
+        SIREN_TEST_ASSERT(loop.write(fds[1], data, sizeof(data)) < 0);
+        e = errno;
+    });
+
+    loop.createFiber([&] () -> void {
+        loop.usleep(10 * 1000);
+        loop.close(fds[0]);
+    });
+
+    loop.run();
+    SIREN_TEST_ASSERT(sigaction(SIGPIPE, &osa, nullptr) == 0);
+    SIREN_TEST_ASSERT(e == EPIPE);
+    loop.close(fds[1]);
+}
+
+
+SIREN_TEST("Sleep for less than a millisecond")
+{
+    Loop loop;
+    std::chrono::steady_clock::duration d;
+
+    loop.createFiber([&] () -> void {
+        std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < 10; ++i) {
+            loop.usleep(300);
+        }
+
+        d = std::chrono::steady_clock::now() - t;
+    });
+
+    loop.run();
+    SIREN_TEST_ASSERT(d >= std::chrono::microseconds(3000));
+}
+
+
+
+SIREN_TEST("Busy-poll before sleeping")
+{
+    Loop loop(16 * 1024);
+    loop.setBusyPollBudget(std::chrono::milliseconds(1));
+
+    loop.createFiber([&] () -> void {
+        loop.usleep(5 * 1000);
+        loop.usleep(5 * 1000);
+    });
+
+    loop.run();
+    SIREN_TEST_ASSERT(loop.getSpinningTime() >= std::chrono::milliseconds(1));
+    SIREN_TEST_ASSERT(loop.getSleepingTime() >= std::chrono::milliseconds(5));
+}
+
+
+
+SIREN_TEST("Poll/Select multiple loop pipes")
+{
+    int fds1[2];
+    int fds2[2];
+    Loop loop(16 * 1024);
+    loop.pipe(fds1);
+    loop.pipe(fds2);
+
+    loop.createFiber([&] () -> void {
+        pollfd pollFDs[3] = {{fds1[0], POLLIN, 0}, {-1, POLLIN, 0}, {fds2[0], POLLIN, 0}};
+        SIREN_TEST_ASSERT(loop.poll(pollFDs, 3, 10) == 0);
+        SIREN_TEST_ASSERT(loop.poll(pollFDs, 3, -1) == 1);
+        SIREN_TEST_ASSERT(pollFDs[0].revents == 0);
+        SIREN_TEST_ASSERT(pollFDs[1].revents == 0);
+        SIREN_TEST_ASSERT(pollFDs[2].revents == POLLIN);
+        char c;
+        loop.read(fds2[0], &c, 1);
+        fd_set readFDs;
+        FD_ZERO(&readFDs);
+        FD_SET(fds1[0], &readFDs);
+        FD_SET(fds2[0], &readFDs);
+        SIREN_TEST_ASSERT(loop.select(FD_SETSIZE, &readFDs, nullptr, nullptr, nullptr) == 1);
+        SIREN_TEST_ASSERT(FD_ISSET(fds1[0], &readFDs));
+        SIREN_TEST_ASSERT(!FD_ISSET(fds2[0], &readFDs));
+    });
+
+    loop.createFiber([&] () -> void {
+        loop.usleep(20 * 1000);
+        loop.write(fds2[1], "a", 1);
+        loop.usleep(20 * 1000);
+        loop.write(fds1[1], "b", 1);
+    });
+
+    loop.run();
+
+    for (int fd : {fds1[0], fds1[1], fds2[0], fds2[1]}) {
+        loop.close(fd);
+    }
+}
+
+
+SIREN_TEST("Poll unmanaged fds along with loop pipes")
+{
+    int fds1[2];
+    int fds2[2];
+    Loop loop(16 * 1024);
+    loop.pipe(fds1);
+    SIREN_TEST_ASSERT(::pipe(fds2) == 0);
+
+    loop.createFiber([&] () -> void {
+        pollfd pollFDs[2] = {{fds1[0], POLLIN, 0}, {fds2[0], POLLIN, 0}};
+        SIREN_TEST_ASSERT(loop.poll(pollFDs, 2, 10) == 0);
+        SIREN_TEST_ASSERT(loop.poll(pollFDs, 2, -1) == 1);
+        SIREN_TEST_ASSERT(pollFDs[0].revents == 0);
+        SIREN_TEST_ASSERT(pollFDs[1].revents == POLLIN);
+        loop.write(fds1[1], "a", 1);
+        SIREN_TEST_ASSERT(loop.poll(pollFDs, 2, -1) == 2);
+        SIREN_TEST_ASSERT(pollFDs[0].revents == POLLIN);
+        SIREN_TEST_ASSERT(pollFDs[1].revents == POLLIN);
+    });
+
+    loop.createFiber([&] () -> void {
+        loop.usleep(20 * 1000);
+        SIREN_TEST_ASSERT(::write(fds2[1], "b", 1) == 1);
+    });
+
+    loop.run();
+    loop.close(fds1[0]);
+    loop.close(fds1[1]);
+    ::close(fds2[0]);
+    ::close(fds2[1]);
+}
+
+
+SIREN_TEST("Coalesce small writes to loop pipe")
+{
+    int fds[2];
+    Loop loop(16 * 1024);
+    loop.pipe(fds);
+    SIREN_TEST_ASSERT(loop.setWriteCoalescing(fds[1], 4096) == 0);
+
+    loop.createFiber([&] () -> void {
+        char buffer[256];
+        SIREN_TEST_ASSERT(loop.read(fds[0], buffer, sizeof(buffer)) == 100);
+
+        for (int i = 0; i < 100; ++i) {
+            SIREN_TEST_ASSERT(buffer[i] == 'a' + i % 26);
+        }
+
+        SIREN_TEST_ASSERT(loop.read(fds[0], buffer, sizeof(buffer)) == 200);
+        SIREN_TEST_ASSERT(loop.read(fds[0], buffer, sizeof(buffer)) == 0);
+        loop.close(fds[0]);
+    });
+
+    loop.createFiber([&] () -> void {
+        for (int i = 0; i < 100; ++i) {
+            char c = 'a' + i % 26;
+            SIREN_TEST_ASSERT(loop.write(fds[1], &c, 1) == 1);
+        }
+
+        loop.usleep(1000);
+        char data[200] = {};
+        SIREN_TEST_ASSERT(loop.write(fds[1], data, 100) == 100);
+        SIREN_TEST_ASSERT(loop.write(fds[1], data, 100) == 100);
+        SIREN_TEST_ASSERT(loop.flush(fds[1]) == 0);
+        loop.usleep(1000);
+        loop.close(fds[1]);
+    });
+
+    loop.run();
+}
+
+
+SIREN_TEST("Flush coalesced writes on loop close")
+{
+    int fds[2];
+    Loop loop(16 * 1024);
+    loop.pipe(fds);
+    SIREN_TEST_ASSERT(fcntl(fds[1], F_SETPIPE_SZ, 4096) >= 0);
+    SIREN_TEST_ASSERT(loop.setWriteCoalescing(fds[1], 65536) == 0);
+    int n = 0;
+
+    loop.createFiber([&] () -> void {
+        char buffer[1024];
+        ssize_t r;
+
+        while ((r = loop.read(fds[0], buffer, sizeof(buffer))) > 0) {
+            n += r;
+        }
+
+        loop.close(fds[0]);
+    });
+
+    loop.createFiber([&] () -> void {
+        char data[100] = {};
+
+        for (int i = 0; i < 200; ++i) {
+            SIREN_TEST_ASSERT(loop.write(fds[1], data, sizeof(data)) == sizeof(data));
+        }
+
+        SIREN_TEST_ASSERT(loop.close(fds[1]) == 0);
+    });
+
+    loop.run();
+    SIREN_TEST_ASSERT(n == 20000);
+}
+
+
+SIREN_TEST("Time out coalesced writes to stalled peer")
+{
+    int fds[2];
+    SIREN_TEST_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    timeval t = {0, 50 * 1000};
+    SIREN_TEST_ASSERT(setsockopt(fds[1], SOL_SOCKET, SO_SNDTIMEO, &t, sizeof(t)) == 0);
+    Loop loop(16 * 1024);
+    loop.manageFD(fds[1]);
+    SIREN_TEST_ASSERT(loop.setWriteCoalescing(fds[1], 65536) == 0);
+    char data[1024] = {};
+
+    while (::send(fds[1], data, sizeof(data), MSG_DONTWAIT) >= 1) {
+    }
+
+    loop.createFiber([&] () -> void {
+        SIREN_TEST_ASSERT(loop.write(fds[1], data, sizeof(data)) == sizeof(data));
+    });
+
+    loop.run();
+    SIREN_TEST_ASSERT(loop.close(fds[1]) < 0 && errno == ECOMM);
+    SIREN_TEST_ASSERT(fcntl(fds[1], F_GETFD) < 0 && errno == EBADF);
+    ::close(fds[0]);
+    SIREN_TEST_ASSERT(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+    loop.manageFD(fds[1]);
+    SIREN_TEST_ASSERT(loop.setWriteCoalescing(fds[1], 65536) == 0);
+
+    while (::send(fds[1], data, sizeof(data), MSG_DONTWAIT) >= 1) {
+    }
+
+    SIREN_TEST_ASSERT(loop.write(fds[1], data, sizeof(data)) == sizeof(data));
+    SIREN_TEST_ASSERT(loop.close(fds[1]) < 0 && errno == ECOMM);
+    SIREN_TEST_ASSERT(fcntl(fds[1], F_GETFD) < 0 && errno == EBADF);
+    ::close(fds[0]);
+}
+
+
+SIREN_TEST("Wait for signal in loop fiber")
+{
+    sigset_t ss, oss;
+    sigemptyset(&ss);
+    sigaddset(&ss, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &ss, &oss);
+    Loop loop;
+    int s = 0;
+
+    loop.createFiber([&] () -> void {
+        siginfo_t si;
+        s = loop.waitForSignal(&ss, &si);
+        SIREN_TEST_ASSERT(si.si_signo == SIGUSR1);
+    });
+
+    loop.createFiber([&] () -> void {
+        loop.usleep(1000);
+        SIREN_TEST_ASSERT(s == 0);
+        pthread_kill(pthread_self(), SIGUSR1);
+    });
+
+    loop.run();
+    SIREN_TEST_ASSERT(s == SIGUSR1);
+    pthread_sigmask(SIG_SETMASK, &oss, nullptr);
+}
+
 }
@@ -0,0 +1,48 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "async.h"
+#include "loop.h"
+#include "mapped_file.h"
+#include "test.h"
+
+
+namespace {
+
+using namespace siren;
+
+
+SIREN_TEST("Prefetch mapped file range")
+{
+    char n[] = "/tmp/siren-test-XXXXXX";
+    int fd = mkstemp(n);
+    SIREN_TEST_ASSERT(fd >= 0);
+    char b[10000];
+
+    for (std::size_t i = 0; i < sizeof(b); ++i) {
+        b[i] = i % 251;
+    }
+
+    SIREN_TEST_ASSERT(write(fd, b, sizeof(b)) == sizeof(b));
+    close(fd);
+    Loop l(64 * 1024);
+    Async a(&l, 1);
+    MappedFile f(n);
+    unlink(n);
+    SIREN_TEST_ASSERT(f.getSize() == sizeof(b));
+
+    l.createFiber([&] () -> void {
+        f.prefetch(&a, 5000, 100000);
+        SIREN_TEST_ASSERT(f.isResident(5000, 100000));
+        SIREN_TEST_ASSERT(std::memcmp(f.getData(5000), b + 5000, sizeof(b) - 5000) == 0);
+    });
+
+    l.run();
+    MappedFile f2(std::move(f));
+    SIREN_TEST_ASSERT(f2.getSize() == sizeof(b) && f.getSize() == 0);
+}
+
+}
@@ -84,4 +84,31 @@ SIREN_TEST("Move memory pools")
     }
 }
 
+
+
+SIREN_TEST("Allocate memory blocks from NUMA-local chunks")
+{
+    MemoryPool mp(0, 1000);
+    mp.setNUMALocal(true);
+    SIREN_TEST_ASSERT(mp.isNUMALocal());
+    char *ps[64];
+
+    for (int i = 0; i < 64; ++i) {
+        ps[i] = static_cast<char *>(mp.allocateBlock());
+        SIREN_TEST_ASSERT(ps[i] != nullptr);
+        ps[i][0] = i;
+        ps[i][999] = i;
+    }
+
+    MemoryPool mp2 = std::move(mp);
+
+    for (int i = 0; i < 64; ++i) {
+        SIREN_TEST_ASSERT(ps[i][0] == i && ps[i][999] == i);
+        mp2.freeBlock(ps[i]);
+    }
+
+    mp2.reset();
+    SIREN_TEST_ASSERT(mp2.allocateBlock() != nullptr);
+}
+
 }
@@ -12,7 +12,7 @@ using namespace siren;
 
 SIREN_TEST("Lock/Unlock mutexes")
 {
-    Scheduler sched;
+    Scheduler sched(64 * 1024);
     Mutex m(&sched);
     std::mt19937 gen((std::random_device())());
     char c[2];
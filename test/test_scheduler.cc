@@ -15,7 +15,7 @@ SIREN_TEST("Interrupt fibers")
     int i = 3;
 
     {
-        Scheduler scheduler;
+        Scheduler scheduler(64 * 1024);
 
         void *fh = scheduler.createFiber([&scheduler, &i] () -> void {
             auto sg = MakeScopeGuard([&i] () -> void { --i; });
@@ -112,10 +112,10 @@ SIREN_TEST("Create background fibers")
     int s = 1;
 
     {
-        Scheduler sched;
+        Scheduler sched(64 * 1024);
 
         {
-            Scheduler temp;
+            Scheduler temp(64 * 1024);
             temp.createFiber([] () -> void {});
 
             temp.createFiber([&sched, &s] () -> void {
@@ -12,7 +12,7 @@ using namespace siren;
 
 SIREN_TEST("Up/Down semaphores")
 {
-    Scheduler sched;
+    Scheduler sched(64 * 1024);
     Semaphore sem(&sched, 0, 0, 10);
     std::list<int> p;
 
@@ -0,0 +1,123 @@
+#include <atomic>
+#include <exception>
+
+#include "ip_endpoint.h"
+#include "loop.h"
+#include "tcp_server.h"
+#include "tcp_socket.h"
+#include "test.h"
+
+
+namespace {
+
+using namespace siren;
+
+
+SIREN_TEST("Spread TCP connections across server loops")
+{
+    std::atomic<int> n(0);
+
+    TCPServer s(IPEndpoint(0x7F000001, 0), [&] (Loop *, TCPSocket cs, IPEndpoint) -> void {
+        char c;
+        SIREN_TEST_ASSERT(cs.read(&c, 1) == 1);
+        cs.write(&c, 1);
+        ++n;
+    }, 4, 511, nullptr, 64 * 1024);
+
+    Loop l(64 * 1024);
+
+    for (int i = 0; i < 20; ++i) {
+        l.createFiber([&] () -> void {
+            TCPSocket cs(&l);
+            cs.connect(s.getLocalEndpoint());
+            char c = 'x';
+            cs.write(&c, 1);
+            SIREN_TEST_ASSERT(cs.read(&c, 1) == 1 && c == 'x');
+        });
+    }
+
+    l.run();
+    s.stop();
+    SIREN_TEST_ASSERT(n.load() == 20);
+}
+
+
+
+SIREN_TEST("Contain TCP server handler exceptions per connection")
+{
+    std::atomic<int> n(0);
+    std::atomic<int> m(0);
+
+    TCPServer s(IPEndpoint(0x7F000001, 0), [&] (Loop *, TCPSocket cs, IPEndpoint) -> void {
+        char c;
+
+        if (cs.read(&c, 1) == 1 && c == 'e') {
+            throw 239;
+        }
+
+        cs.write(&c, 1);
+        ++n;
+    }, 2, 511, [&] (Loop *, IPEndpoint ipe, std::exception_ptr e) -> void {
+        try {
+            std::rethrow_exception(e);
+        } catch (int i) {
+            if (ipe.address == 0x7F000001 && i == 239) {
+                ++m;
+            }
+        }
+    }, 64 * 1024);
+
+    Loop l(64 * 1024);
+
+    for (int i = 0; i < 10; ++i) {
+        l.createFiber([&, i] () -> void {
+            TCPSocket cs(&l);
+            cs.connect(s.getLocalEndpoint());
+            char c = i % 2 == 0 ? 'e' : 'x';
+            cs.write(&c, 1);
+
+            if (i % 2 == 0) {
+                SIREN_TEST_ASSERT(cs.read(&c, 1) == 0);
+            } else {
+                SIREN_TEST_ASSERT(cs.read(&c, 1) == 1 && c == 'x');
+            }
+        });
+    }
+
+    l.run();
+    s.stop();
+    SIREN_TEST_ASSERT(n.load() == 5);
+    SIREN_TEST_ASSERT(m.load() == 5);
+}
+
+
+
+SIREN_TEST("Stop TCP server with open connections")
+{
+    std::atomic<bool> f(false);
+
+    TCPServer s(IPEndpoint(0x7F000001, 0), [&] (Loop *, TCPSocket cs, IPEndpoint) -> void {
+        f.store(true);
+        char c;
+        cs.read(&c, 1);
+    }, 1, 511, nullptr, 64 * 1024);
+
+    Loop l(64 * 1024);
+
+    l.createFiber([&] () -> void {
+        TCPSocket cs(&l);
+        cs.connect(s.getLocalEndpoint());
+
+        while (!f.load()) {
+            l.usleep(1000);
+        }
+
+        s.stop();
+        char c;
+        SIREN_TEST_ASSERT(cs.read(&c, 1) == 0);
+    });
+
+    l.run();
+}
+
+}
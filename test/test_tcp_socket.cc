@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <cstring>
 
 #include "ip_endpoint.h"
@@ -60,7 +61,7 @@ SIREN_TEST("Ping-Pong sample")
 
 SIREN_TEST("TCP echo client/server")
 {
-    Loop l;
+    Loop l(64 * 1024);
 
     l.createFiber([&] () -> void {
         TCPSocket ss(&l);
@@ -103,5 +104,161 @@ SIREN_TEST("TCP echo client/server")
     l.run();
 }
 
+
+SIREN_TEST("Relay sendfile data through TCP proxy")
+{
+    Loop l(64 * 1024);
+    std::FILE *f = std::tmpfile();
+    const char m[] = "hello, sendfile!";
+    std::fwrite(m, 1, sizeof(m), f);
+    std::fflush(f);
+
+    l.createFiber([&] () -> void {
+        TCPSocket ss1(&l);
+        ss1.setReuseAddress(true);
+        ss1.listen(IPEndpoint(0, 0));
+        IPEndpoint ipe1 = ss1.getLocalEndpoint();
+        TCPSocket ss2(&l);
+        ss2.setReuseAddress(true);
+        ss2.listen(IPEndpoint(0, 0));
+        IPEndpoint ipe2 = ss2.getLocalEndpoint();
+
+        l.createFiber([&] () -> void {
+            TCPSocket cs(&l);
+            cs.connect(ipe1);
+            off_t o = 0;
+            SIREN_TEST_ASSERT(cs.sendFile(fileno(f), &o, sizeof(m)) == sizeof(m));
+            SIREN_TEST_ASSERT(o == sizeof(m));
+            cs.closeWrite();
+        });
+
+        l.createFiber([&] () -> void {
+            TCPSocket cs1 = ss1.accept();
+            TCPSocket cs2(&l);
+            cs2.connect(ipe2);
+            SIREN_TEST_ASSERT(cs1.relay(&cs2) == sizeof(m));
+            cs2.closeWrite();
+        });
+
+        TCPSocket cs = ss2.accept();
+        Stream s;
+        s.reserveBuffer(100);
+        while (cs.read(&s) >= 1);
+        SIREN_TEST_ASSERT(s.getDataSize() == sizeof(m));
+        SIREN_TEST_ASSERT(std::strcmp(static_cast<char *>(s.getData()), m) == 0);
+    });
+
+    l.run();
+    std::fclose(f);
+}
+
+
+SIREN_TEST("Send large TCP writes with zero copy")
+{
+    Loop l(64 * 1024);
+
+    l.createFiber([&] () -> void {
+        TCPSocket ss(&l);
+        ss.setReuseAddress(true);
+        ss.listen(IPEndpoint(0, 0));
+        IPEndpoint ipe = ss.getLocalEndpoint();
+
+        l.createFiber([&] () -> void {
+            TCPSocket cs(&l);
+            cs.connect(ipe);
+            cs.setZeroCopy(64 * 1024);
+            std::size_t n = 1024 * 1024;
+            char *m = new char[n];
+
+            for (char c : {'x', 'y'}) {
+                std::memset(m, c, n);
+
+                for (std::size_t i = 0; i < n;) {
+                    i += cs.write(m + i, n - i);
+                    cs.waitForZeroCopy(cs.getZeroCopySequenceNumber());
+                }
+            }
+
+            delete[] m;
+            Stream s;
+            s.reserveBuffer(n);
+            std::memset(s.getBuffer(), 'z', n);
+            s.commitBuffer(n);
+
+            while (s.getDataSize() >= 1) {
+                cs.write(&s);
+            }
+
+            cs.flush();
+            cs.closeWrite();
+        });
+
+        TCPSocket cs = ss.accept();
+        Stream s;
+        std::size_t n = 0;
+
+        for (;;) {
+            s.reserveBuffer(64 * 1024);
+            std::size_t numberOfBytes = cs.read(&s);
+
+            if (numberOfBytes == 0) {
+                break;
+            }
+
+            auto d = static_cast<char *>(s.getData());
+
+            for (std::size_t i = 0; i < numberOfBytes; ++i, ++n) {
+                SIREN_TEST_ASSERT(d[i] == "xyz"[n / (1024 * 1024)]);
+            }
+
+            s.reset();
+        }
+
+        SIREN_TEST_ASSERT(n == 3 * 1024 * 1024);
+    });
+
+    l.run();
+}
+
+
+SIREN_TEST("Serve TCP connections in batches")
+{
+    Loop l(64 * 1024);
+    TCPSocket ss(&l);
+    ss.setReuseAddress(true);
+    ss.listen(IPEndpoint(0, 0));
+    IPEndpoint ipe = ss.getLocalEndpoint();
+    int n = 0;
+    bool f2 = false;
+
+    void *f = l.createFiber([&] () -> void {
+        ss.serve([&] (TCPSocket cs, IPEndpoint ipe2) -> void {
+            SIREN_TEST_ASSERT(ipe2.address == 0x7F000001);
+            char c;
+            SIREN_TEST_ASSERT(cs.read(&c, 1) == 1);
+            cs.write(&c, 1);
+        });
+
+        f2 = true;
+    });
+
+    for (int i = 0; i < 10; ++i) {
+        l.createFiber([&] () -> void {
+            TCPSocket cs(&l);
+            cs.connect(IPEndpoint(0x7F000001, ipe.portNumber));
+            char c = 'x';
+            cs.write(&c, 1);
+            SIREN_TEST_ASSERT(cs.read(&c, 1) == 1 && c == 'x');
+
+            if (++n == 10) {
+                l.interruptFiber(f);
+            }
+        });
+    }
+
+    l.run();
+    SIREN_TEST_ASSERT(f2);
+}
+
 }
 
@@ -1,5 +1,11 @@
+#include <cerrno>
 #include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <system_error>
 
+#include <sched.h>
 #include <unistd.h>
 
 #include "assert.h"
@@ -85,4 +91,366 @@ SIREN_TEST("Remove thread pool tasks")
     }
 }
 
+
+
+SIREN_TEST("Add thread pool tasks beyond queue capacity")
+{
+    struct MyThreadPoolTask : ThreadPoolTask
+    {
+    };
+
+    std::atomic<int> a(0);
+    ThreadPool tp(4, 8);
+    MyThreadPoolTask ts[1000];
+    int n = 1000;
+
+    auto removeCompletedTasks = [&] () -> void {
+        std::uint64_t dummy;
+        int r = read(tp.getEventFD(), &dummy, sizeof(dummy));
+        SIREN_UNUSED(r);
+        SIREN_ASSERT(r == sizeof(dummy));
+
+        tp.removeCompletedTasks([&] (ThreadPoolTask *x) -> void {
+            x->check();
+            --n;
+        });
+    };
+
+    for (MyThreadPoolTask &t : ts) {
+        for (;;) {
+            try {
+                tp.addTask(&t, [&a] () -> void {
+                    a.fetch_add(1, std::memory_order_relaxed);
+                    usleep(100);
+                });
+
+                break;
+            } catch (const std::system_error &e) {
+                SIREN_TEST_ASSERT(e.code().value() == EAGAIN);
+            }
+
+            removeCompletedTasks();
+        }
+    }
+
+    while (n >= 1) {
+        removeCompletedTasks();
+    }
+
+    SIREN_TEST_ASSERT(a.load(std::memory_order_relaxed) == 1000);
+
+    ThreadPoolTask *ts2[20];
+
+    for (int i = 0; i < 20; ++i) {
+        ts2[i] = &ts[i];
+    }
+
+    std::size_t k = tp.tryAddTasks(ts2, 20, [] (ThreadPoolTask *) -> void {
+    });
+
+    SIREN_TEST_ASSERT(k == 8);
+    n = 8;
+
+    while (n >= 1) {
+        removeCompletedTasks();
+    }
+}
+
+
+
+SIREN_TEST("Fork and join thread pool tasks")
+{
+    struct MyThreadPoolTask : ThreadPoolTask
+    {
+    };
+
+    ThreadPool tp(4);
+    std::function<long (long, long)> sum;
+
+    sum = [&] (long i, long j) -> long {
+        if (j - i <= 100) {
+            long k = 0;
+
+            for (; i < j; ++i) {
+                k += i;
+            }
+
+            return k;
+        }
+
+        long m = i + (j - i) / 2;
+        long k;
+        MyThreadPoolTask t;
+
+        tp.forkTask(&t, [&] () -> void {
+            k = sum(i, m);
+        });
+
+        long l = sum(m, j);
+        tp.joinTask(&t);
+        return k + l;
+    };
+
+    MyThreadPoolTask t;
+    long k = 0;
+    bool thrown = false;
+
+    tp.addTask(&t, [&] () -> void {
+        k = sum(0, 100000);
+        MyThreadPoolTask t2;
+
+        tp.forkTask(&t2, [] () -> void {
+            throw 1;
+        });
+
+        try {
+            tp.joinTask(&t2);
+        } catch (int) {
+            thrown = true;
+        }
+    });
+
+    std::uint64_t dummy;
+    int r = read(tp.getEventFD(), &dummy, sizeof(dummy));
+    SIREN_UNUSED(r);
+    SIREN_ASSERT(r == sizeof(dummy));
+
+    tp.removeCompletedTasks([&] (ThreadPoolTask *x) -> void {
+        x->check();
+    });
+
+    SIREN_TEST_ASSERT(k == 100000L * 99999 / 2);
+    SIREN_TEST_ASSERT(thrown);
+}
+
+
+
+SIREN_TEST("Coalesce thread pool completion events")
+{
+    struct MyThreadPoolTask : ThreadPoolTask
+    {
+    };
+
+    std::atomic<bool> a(false);
+    ThreadPool tp(1);
+    MyThreadPoolTask ts[101];
+
+    tp.addTask(&ts[0], [&a] () -> void {
+        while (!a.load(std::memory_order_acquire)) {
+            usleep(1000);
+        }
+    });
+
+    for (int i = 1; i < 101; ++i) {
+        tp.addTask(&ts[i], [] () -> void {
+        });
+    }
+
+    a.store(true, std::memory_order_release);
+    int n = 101;
+    std::uint64_t m = 0;
+
+    do {
+        std::uint64_t k;
+        int r = read(tp.getEventFD(), &k, sizeof(k));
+        SIREN_UNUSED(r);
+        SIREN_ASSERT(r == sizeof(k));
+        m += k;
+
+        tp.removeCompletedTasks([&] (ThreadPoolTask *x) -> void {
+            x->check();
+            --n;
+        });
+    } while (n >= 1);
+
+    SIREN_TEST_ASSERT(m < 101);
+}
+
+
+
+SIREN_TEST("Grow and shrink thread pool with load")
+{
+    struct MyThreadPoolTask : ThreadPoolTask
+    {
+    };
+
+    ThreadPool tp(1, 0, 4);
+    tp.setSpawnDelay(std::chrono::milliseconds(1));
+    tp.setIdleTimeout(std::chrono::milliseconds(200));
+    SIREN_TEST_ASSERT(tp.getNumberOfThreads() == 1);
+    MyThreadPoolTask ts[8];
+
+    for (MyThreadPoolTask &t : ts) {
+        tp.addTask(&t, [] () -> void {
+            usleep(50 * 1000);
+        });
+    }
+
+    int n = 8;
+
+    do {
+        std::uint64_t dummy;
+        int r = read(tp.getEventFD(), &dummy, sizeof(dummy));
+        SIREN_UNUSED(r);
+        SIREN_ASSERT(r == sizeof(dummy));
+
+        tp.removeCompletedTasks([&] (ThreadPoolTask *x) -> void {
+            x->check();
+            --n;
+        });
+    } while (n >= 1);
+
+    SIREN_TEST_ASSERT(tp.getNumberOfThreads() >= 2);
+    SIREN_TEST_ASSERT(tp.getNumberOfDequeuedTasks() == 8);
+    SIREN_TEST_ASSERT(tp.getTotalQueueLatency() >= std::chrono::milliseconds(50));
+
+    while (tp.getNumberOfThreads() >= 2) {
+        usleep(10 * 1000);
+    }
+
+    SIREN_TEST_ASSERT(tp.getNumberOfThreads() == 1);
+    SIREN_TEST_ASSERT(tp.getNumberOfActiveThreads() == 0);
+}
+
+
+
+SIREN_TEST("Spawn thread pool thread for task queued behind blocked worker")
+{
+    struct MyThreadPoolTask : ThreadPoolTask
+    {
+    };
+
+    ThreadPool tp(1, 0, 2);
+    tp.setSpawnDelay(std::chrono::milliseconds(10));
+    MyThreadPoolTask t1, t2;
+    std::atomic<bool> f1(false), f2(false);
+
+    tp.addTask(&t1, [&] () -> void {
+        f1.store(true);
+
+        for (int i = 0; i < 200 && !f2.load(); ++i) {
+            usleep(10 * 1000);
+        }
+    });
+
+    while (!f1.load()) {
+        usleep(1000);
+    }
+
+    tp.addTask(&t2, [&] () -> void {
+        f2.store(true);
+    });
+
+    int n = 2;
+
+    do {
+        std::uint64_t dummy;
+        int r = read(tp.getEventFD(), &dummy, sizeof(dummy));
+        SIREN_UNUSED(r);
+        SIREN_ASSERT(r == sizeof(dummy));
+
+        tp.removeCompletedTasks([&] (ThreadPoolTask *x) -> void {
+            if (x == &t1) {
+                SIREN_TEST_ASSERT(f2.load());
+            }
+
+            x->check();
+            --n;
+        });
+    } while (n >= 1);
+
+    SIREN_TEST_ASSERT(tp.getNumberOfThreads() == 2);
+    SIREN_TEST_ASSERT(tp.getNumberOfSpawnFailures() == 0);
+}
+
+
+SIREN_TEST("Keep interactive lane clear of bulk thread pool tasks")
+{
+    struct MyThreadPoolTask : ThreadPoolTask
+    {
+    };
+
+    ThreadPool tp(2);
+    MyThreadPoolTask ts[5];
+    std::atomic<int> a(0), b(0), c(0);
+    std::atomic<bool> e(false);
+    int d = -1;
+
+    for (int i = 0; i < 4; ++i) {
+        tp.addTask(&ts[i], [&] () -> void {
+            int n = a.fetch_add(1) + 1;
+            int m = b.load();
+
+            while (n > m && !b.compare_exchange_weak(m, n)) {
+            }
+
+            while (!e.load()) {
+                usleep(1000);
+            }
+
+            a.fetch_sub(1);
+            c.fetch_add(1);
+        }, ThreadPoolLane::Bulk);
+    }
+
+    tp.addTask(&ts[4], [&] () -> void {
+        d = c.load();
+        e.store(true);
+    });
+
+    int n = 5;
+
+    do {
+        std::uint64_t dummy;
+        int r = read(tp.getEventFD(), &dummy, sizeof(dummy));
+        SIREN_UNUSED(r);
+        SIREN_ASSERT(r == sizeof(dummy));
+
+        tp.removeCompletedTasks([&] (ThreadPoolTask *x) -> void {
+            x->check();
+            --n;
+        });
+    } while (n >= 1);
+
+    SIREN_TEST_ASSERT(b.load() == 1);
+    SIREN_TEST_ASSERT(d == 0);
+}
+
+
+
+SIREN_TEST("Pin thread pool workers to CPUs")
+{
+    struct MyThreadPoolTask : ThreadPoolTask
+    {
+    };
+
+    int cpu = sched_getcpu();
+    SIREN_TEST_ASSERT(cpu >= 0);
+    cpu_set_t cs;
+    CPU_ZERO(&cs);
+    CPU_SET(cpu, &cs);
+    ThreadPool tp(1, 0, 2);
+    tp.setCPUAffinity(cs);
+    MyThreadPoolTask t;
+    bool f = false;
+
+    tp.addTask(&t, [&] () -> void {
+        cpu_set_t cs2;
+        CPU_ZERO(&cs2);
+        f = sched_getaffinity(0, sizeof(cs2), &cs2) == 0 && CPU_COUNT(&cs2) == 1
+            && CPU_ISSET(cpu, &cs2);
+    });
+
+    std::uint64_t dummy;
+    int r = read(tp.getEventFD(), &dummy, sizeof(dummy));
+    SIREN_UNUSED(r);
+    SIREN_ASSERT(r == sizeof(dummy));
+
+    tp.removeCompletedTasks([&] (ThreadPoolTask *x) -> void {
+        x->check();
+    });
+
+    SIREN_TEST_ASSERT(f);
+}
+
 }
@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <cstring>
+
+#include "ip_endpoint.h"
+#include "loop.h"
+#include "test.h"
+#include "udp_socket.h"
+
+
+namespace {
+
+using namespace siren;
+
+
+SIREN_TEST("Batch send/receive UDP datagrams")
+{
+    Loop l(64 * 1024);
+    UDPSocket ss(&l);
+    ss.bind(IPEndpoint(0x7F000001, 0));
+    IPEndpoint ipe = ss.getLocalEndpoint();
+
+    l.createFiber([&] () -> void {
+        char buffers[16][100];
+        UDPDatagram ds[16];
+
+        for (int i = 0; i < 16; ++i) {
+            ds[i].data = buffers[i];
+            ds[i].dataSize = sizeof(buffers[i]);
+        }
+
+        SIREN_TEST_ASSERT(ss.receiveMany(ds, 16) == 10);
+
+        for (int i = 0; i < 10; ++i) {
+            char m[100];
+            std::sprintf(m, "datagram %d", i);
+            SIREN_TEST_ASSERT(ds[i].dataSize == std::strlen(m) + 1);
+            SIREN_TEST_ASSERT(std::strcmp(buffers[i], m) == 0);
+        }
+    });
+
+    l.createFiber([&] () -> void {
+        UDPSocket cs(&l);
+        char buffers[10][100];
+        UDPDatagram ds[10];
+
+        for (int i = 0; i < 10; ++i) {
+            ds[i].data = buffers[i];
+            ds[i].dataSize = std::sprintf(buffers[i], "datagram %d", i) + 1;
+            ds[i].endpoint = ipe;
+        }
+
+        SIREN_TEST_ASSERT(cs.sendMany(ds, 10) == 10);
+    });
+
+    l.run();
+}
+
+}
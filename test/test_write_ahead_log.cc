@@ -0,0 +1,84 @@
+#include <cstdlib>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "async.h"
+#include "loop.h"
+#include "test.h"
+#include "write_ahead_log.h"
+
+
+namespace {
+
+using namespace siren;
+
+
+SIREN_TEST("Group-commit and replay write-ahead log records")
+{
+    char d[] = "/tmp/siren-test-XXXXXX";
+    SIREN_TEST_ASSERT(mkdtemp(d) != nullptr);
+    Loop l(64 * 1024);
+    Async a(&l, 2);
+
+    l.createFiber([&] () -> void {
+        WriteAheadLog w(&l, &a, d, 1024, std::chrono::microseconds(0), 256);
+        int n = 0;
+
+        for (int i = 0; i < 100; ++i) {
+            l.createFiber([&, i] () -> void {
+                l.usleep(i % 4 * 5000);
+                w.append(std::string("record ") + std::to_string(i));
+                ++n;
+            });
+        }
+
+        while (n < 100) {
+            l.usleep(1000);
+        }
+    });
+
+    l.run();
+    close(creat((std::string(d) + "/00000000000000000000.wal.bak").c_str(), 0644));
+    std::vector<std::string> rs;
+
+    l.createFiber([&] () -> void {
+        WriteAheadLog w(&l, &a, d);
+
+        w.replay<std::string>([&] (std::string r) -> void {
+            rs.push_back(std::move(r));
+        });
+    });
+
+    l.run();
+    SIREN_TEST_ASSERT(rs.size() == 100);
+    std::vector<std::string> rs2;
+
+    for (int i = 0; i < 100; ++i) {
+        rs2.push_back(std::string("record ") + std::to_string(i));
+    }
+
+    std::sort(rs.begin(), rs.end());
+    std::sort(rs2.begin(), rs2.end());
+    SIREN_TEST_ASSERT(rs == rs2);
+
+    DIR *x = opendir(d);
+    int m = 0;
+
+    for (dirent *e; (e = readdir(x)) != nullptr;) {
+        if (e->d_name[0] != '.') {
+            unlink((std::string(d) + "/" + e->d_name).c_str());
+            ++m;
+        }
+    }
+
+    closedir(x);
+    rmdir(d);
+    SIREN_TEST_ASSERT(m >= 2);
+}
+
+}